@@ -0,0 +1,80 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * \file dsplug_data_buffer.h
+ * \author Juan Linietsky
+ */
+
+#ifndef DSPLUG_DATA_BUFFER_H
+#define DSPLUG_DATA_BUFFER_H
+
+#include "dsplug_types.h"
+
+/****************************/
+
+/* DATA BUFFER */
+
+/****************************/
+
+/*
+	Immutable, reference counted block of data. Plugins use it to hand out
+	the contents of data ports without copying them every time the host asks
+	(see DSPlug_ControlPortCreation_set_data_buffer_callback): a plugin keeps
+	a reference to the buffer of its current data, and gives the host a new
+	reference on each request. The data is freed when the last reference is
+	released. References can be taken and released from any thread, but the
+	last release frees memory, so keep one out of the realtime thread.
+*/
+
+/**
+ *	Create a buffer with a copy of the data, in a single allocation.
+ *	\param d data to copy
+ *	\param l length of the data in bytes
+ *	\return the buffer, with one reference, NULL on error
+ */
+
+DSPlug_DataBuffer * DSPlug_DataBuffer_create( const void *d, int l );
+
+/**
+ *	Create a buffer around existing data, without copying it. The data must
+ *	not change while the buffer exists, and is given to f when the last
+ *	reference is released.
+ *	\param d data
+ *	\param l length of the data in bytes
+ *	\param f callback to free the data, receives the data and u, may be NULL
+ *	\param u userdata for f
+ *	\return the buffer, with one reference, NULL on error
+ */
+
+DSPlug_DataBuffer * DSPlug_DataBuffer_create_wrapped( const void *d, int l, void (*f)(const void *, void *), void *u );
+
+/**
+ *	Take a new reference to the buffer.
+ */
+
+void DSPlug_DataBuffer_retain( DSPlug_DataBuffer * );
+
+/**
+ *	Release a reference, the buffer is freed with the last one.
+ */
+
+void DSPlug_DataBuffer_release( DSPlug_DataBuffer * );
+
+const void * DSPlug_DataBuffer_get_data( DSPlug_DataBuffer * );
+int DSPlug_DataBuffer_get_length( DSPlug_DataBuffer * );
+
+#endif /* dsplug_data_buffer.h */
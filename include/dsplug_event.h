@@ -1 +1,476 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
 
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/**
+ * \file dsplug_event.h
+ * \author Juan Linietsky
+ */
+
+#ifndef DSPLUG_EVENT_H
+#define DSPLUG_EVENT_H
+
+#include "dsplug_types.h"
+
+/* Defines */
+
+#define DSPLUG_EVENT_QUEUE_DEFAULT_CAPACITY 1024
+#define DSPLUG_EVENT_QUEUE_MAX_CAPACITY (1<<20)
+#define DSPLUG_EVENT_PAYLOAD_ARENA_MAX_SIZE (1<<24)
+#define DSPLUG_EVENT_PAYLOAD_ALIGNMENT 8
+#define DSPLUG_EVENT_QUEUE_MAX_READERS 16
+#define DSPLUG_EVENT_QUEUE_COALESCE_WINDOW 32 /* newest events searched for a controller change to replace */
+
+/****************************/
+
+/* EVENT */
+
+/****************************/
+
+/**
+ * A single event. Events are small and of fixed size, so they can be
+ * copied around freely and stored in preallocated queues.
+ */
+typedef struct {
+
+	int frame; /**< Frame offset of the event, relative to the beginning of the processed block */
+	int type; /**< Event type, its meaning depends on the event type of the port */
+
+	union {
+		unsigned char bytes[8]; /**< Raw bytes, MIDI messages are stored here */
+		int integers[2];
+		float floats[2];
+		double real;
+	} data;
+
+} DSPlug_Event;
+
+
+/****************************/
+
+/* EVENT QUEUE */
+
+/****************************/
+
+/*
+	Event queues are fixed capacity, single-producer/single-consumer rings.
+	Pushing and popping never allocates memory nor takes locks, and
+	neither side ever waits for the other, so the host can fill a queue
+	from its sequencer thread while the plugin drains it inside the process
+	callback. Only one thread may push and only one thread may pop at a
+	given time. Events must be pushed in frame order.
+*/
+
+/**
+ * What DSPlug_EventQueue_push does when the queue is full
+ */
+typedef enum {
+
+	DSPLUG_EVENT_QUEUE_OVERFLOW_DROP_NEWEST		= 0, /**< The pushed event is dropped (default) */
+
+	/**
+	* The oldest pending event is dropped to make room. The producer then
+	* moves the read position, so pointers returned by DSPlug_EventQueue_peek
+	* may see the slot overwritten while the producer is pushing.
+	*/
+	DSPLUG_EVENT_QUEUE_OVERFLOW_DROP_OLDEST		= 1,
+
+	/**
+	* For DSPLUG_EVENT_TYPE_MIDI queues. A controller change replaces the value of
+	* the newest pending change of the same controller and channel, keeping its
+	* frame, among the last DSPLUG_EVENT_QUEUE_COALESCE_WINDOW events pushed.
+	* Other events, or changes with no pending match, are dropped.
+	* Only changes no consumer has reached yet are replaced. If a consumer gets to
+	* it meanwhile, the new change is pushed if that made room, or dropped.
+	*/
+	DSPLUG_EVENT_QUEUE_OVERFLOW_COALESCE_CONTROLLERS	= 2,
+
+} DSPlug_EventQueueOverflowPolicy;
+
+/**
+ *	Create an event queue. This allocates memory, so it must NOT
+ *	be called from a realtime thread.
+ *	\param c capacity in events, it will be rounded up to a power of two. Zero means DSPLUG_EVENT_QUEUE_DEFAULT_CAPACITY.
+ *	\return a new event queue, NULL on error
+ */
+
+DSPlug_EventQueue * DSPlug_EventQueue_create( int c );
+
+/**
+ *	Create an event queue with a payload arena, for events that carry
+ *	more data than fits in an event (SysEx dumps, strings, blobs). This
+ *	allocates memory, so it must NOT be called from a realtime thread.
+ *	\param c capacity in events, as in DSPlug_EventQueue_create()
+ *	\param p size of the payload arena in bytes, zero for no arena
+ *	\return a new event queue, NULL on error
+ */
+
+DSPlug_EventQueue * DSPlug_EventQueue_create_with_payload_arena( int c, int p );
+
+/**
+ *	Destroy an event queue or reader view. Make sure no plugin has it connected
+ *	anymore. Reader views of a queue must be destroyed before the queue.
+ *	As with DSPlug_EventQueue_create_reader(), destroying a reader view
+ *	must NOT be done while its source queue is being pushed to.
+ */
+
+void DSPlug_EventQueue_destroy( DSPlug_EventQueue * );
+
+/**
+ *	Create a reader view of a queue, to fan out the events of a queue to
+ *	several consumers without copying them, for example connecting the output
+ *	event port of a filter plugin to the input ports of many instances.
+ *	A view shares the events and payloads of its source queue, and has its own
+ *	read position, so it can be connected as an input and popped like any queue,
+ *	but it can't be pushed to. The source queue keeps its own read position, so
+ *	it counts as one more consumer: either connect it too, or flush it after every
+ *	cycle. The producer sees the queue as full until all consumers are past an event.
+ *	A view starts empty, seeing only the events pushed after its creation.
+ *	This allocates memory and must NOT be called while the queue is being pushed to.
+ *	\param q source queue, not a view
+ *	\return a new reader view, NULL on error
+ */
+
+DSPlug_EventQueue * DSPlug_EventQueue_create_reader( DSPlug_EventQueue *q );
+
+/**
+ *	\return the maximum amount of events the queue can hold
+ */
+
+int DSPlug_EventQueue_get_capacity( DSPlug_EventQueue * );
+
+/**
+ *	Set what happens when pushing to a full queue. Call it before the
+ *	queue is in use.
+ *	\param p overflow policy
+ */
+
+void DSPlug_EventQueue_set_overflow_policy( DSPlug_EventQueue *, DSPlug_EventQueueOverflowPolicy p );
+
+/**
+ *	The statistics below are only written by the producer, and can be read
+ *	from any thread at any time, without locking.
+ *	\return the most events ever pending in the queue at once
+ */
+
+int DSPlug_EventQueue_get_high_water( DSPlug_EventQueue * );
+
+/**
+ *	\return amount of events lost because the queue was full
+ */
+
+int DSPlug_EventQueue_get_dropped_count( DSPlug_EventQueue * );
+
+/**
+ *	\return amount of controller changes merged into a pending one because the queue was full
+ */
+
+int DSPlug_EventQueue_get_coalesced_count( DSPlug_EventQueue * );
+
+/**
+ *	Get the amount of events waiting to be popped. This can be called
+ *	from both the producer and the consumer, though the value may be
+ *	outdated by the time it is used.
+ *	\return amount of pending events
+ */
+
+int DSPlug_EventQueue_get_pending_count( DSPlug_EventQueue * );
+
+/**
+ *	Push an event at the end of the queue (producer side).
+ *	\param ev event to copy into the queue
+ *	\return true if the event was queued (or coalesced), false if it was dropped because the queue is full (or is a reader view)
+ */
+
+DSPlug_Boolean DSPlug_EventQueue_push( DSPlug_EventQueue *, const DSPlug_Event *ev );
+
+/**
+ *	Pop the oldest event from the queue (consumer side).
+ *	\param ev pointer to where the event will be copied
+ *	\return true if an event was popped, false if the queue is empty
+ */
+
+DSPlug_Boolean DSPlug_EventQueue_pop( DSPlug_EventQueue *, DSPlug_Event *ev );
+
+/**
+ *	Pop the oldest event from the queue only if it happens before a given
+ *	frame (consumer side). This is useful for plugins that process their block
+ *	in smaller chunks.
+ *	\param f frame limit, events at this frame or later are left in the queue
+ *	\param ev pointer to where the event will be copied
+ *	\return true if an event was popped
+ */
+
+DSPlug_Boolean DSPlug_EventQueue_pop_before( DSPlug_EventQueue *, int f, DSPlug_Event *ev );
+
+/**
+ *	Look at the oldest event without removing it (consumer side).
+ *	The pointer is valid until the event is popped.
+ *	\return pointer to the event, NULL if the queue is empty
+ */
+
+const DSPlug_Event * DSPlug_EventQueue_peek( DSPlug_EventQueue * );
+
+/**
+ *	Look at a pending event without removing it (consumer side).
+ *	The pointer is valid until the event is popped.
+ *	\param i index of the event, zero is the oldest one
+ *	\return pointer to the event, NULL if there are not that many pending events
+ */
+
+const DSPlug_Event * DSPlug_EventQueue_peek_at( DSPlug_EventQueue *, int i );
+
+/**
+ *	Discard all pending events (consumer side).
+ */
+
+void DSPlug_EventQueue_flush( DSPlug_EventQueue * );
+
+/*
+	Payloads are copied into the arena of the queue, which is a simple
+	bump allocator, and the event only references them by offset
+	(data.integers[0]) and size (data.integers[1]). Nothing is freed
+	individually: the producer resets the whole arena at the beginning of
+	each cycle, so payloads are only valid for the cycle they were pushed
+	in, and the consumer must be done with them by then.
+*/
+
+/**
+ *	Copy a payload into the arena, then push an event referencing it (producer side).
+ *	\param ev event to push, its type and frame are kept and its data is overwritten
+ *	\param payload data to copy
+ *	\param size size of the payload in bytes
+ *	\return true if the event was queued, false if the queue is full or the
+ *	arena ran out of space for this cycle, in which case the overflow count is increased
+ */
+
+DSPlug_Boolean DSPlug_EventQueue_push_payload( DSPlug_EventQueue *, const DSPlug_Event *ev, const void *payload, int size );
+
+/**
+ *	Get the payload referenced by an event popped from the queue (consumer side).
+ *	\param ev event pushed with DSPlug_EventQueue_push_payload()
+ *	\param size if not NULL, the size of the payload is stored here
+ *	\return pointer to the payload in the arena, NULL if the event references no valid payload
+ */
+
+const void * DSPlug_EventQueue_get_payload( DSPlug_EventQueue *, const DSPlug_Event *ev, int *size );
+
+/**
+ *	Reset the payload arena (producer side). Call at the beginning of every
+ *	cycle, before pushing its events, and only once the consumer is done
+ *	with the payloads of the previous cycle.
+ */
+
+void DSPlug_EventQueue_reset_payload_arena( DSPlug_EventQueue * );
+
+/**
+ *	\return size of the payload arena in bytes
+ */
+
+int DSPlug_EventQueue_get_payload_arena_size( DSPlug_EventQueue * );
+
+/**
+ *	\return the most arena bytes ever used in a single cycle
+ */
+
+int DSPlug_EventQueue_get_payload_high_water( DSPlug_EventQueue * );
+
+/**
+ *	\return amount of payloads that didn't fit in the arena since the queue was created
+ */
+
+int DSPlug_EventQueue_get_payload_overflow_count( DSPlug_EventQueue * );
+
+
+/****************************/
+
+/* MASTERTRACK EVENTS */
+
+/****************************/
+
+/**
+ * Types of the events found in DSPLUG_EVENT_TYPE_MASTERTRACK port queues.
+ * Every cycle begins with one event of each type at frame zero, then a tempo
+ * and a beat position event are sent at every tempo change inside the cycle.
+ * Between those, the beat position advances linearly with the tempo.
+ */
+typedef enum {
+
+	DSPLUG_MASTERTRACK_EVENT_TEMPO		= 0, /**< data.real is the tempo in beats per minute */
+	DSPLUG_MASTERTRACK_EVENT_BEAT_POSITION	= 1, /**< data.real is the song position in beats at the event frame */
+	DSPLUG_MASTERTRACK_EVENT_TIME_SIGNATURE	= 2, /**< data.integers[0] is the numerator, data.integers[1] the denominator */
+	DSPLUG_MASTERTRACK_EVENT_KEY		= 3, /**< data.integers[0] is the root note (0 is C, 11 is B), data.integers[1] is true for minor keys */
+
+} DSPlug_MastertrackEventType;
+
+
+/****************************/
+
+/* AUDIO EVENTS */
+
+/****************************/
+
+/**
+ * Types of the events found in DSPLUG_EVENT_TYPE_AUDIO port queues. The host
+ * library generates them for every input port of this type, unless the host
+ * connects a queue of its own. Every cycle begins with one event of each type
+ * at frame zero. While playing, a position event is also sent at every frame
+ * where the transport jumps back to the loop beginning. Between those, the
+ * position advances one frame per frame.
+ */
+typedef enum {
+
+	DSPLUG_AUDIO_EVENT_PLAY_STATE	= 0, /**< data.integers[0] is true while the transport is playing */
+	DSPLUG_AUDIO_EVENT_POSITION	= 1, /**< data.real is the transport position in frames at the event frame */
+	DSPLUG_AUDIO_EVENT_LOOP_BEGIN	= 2, /**< data.real is the loop beginning in frames */
+	DSPLUG_AUDIO_EVENT_LOOP_END	= 3, /**< data.real is the loop end in frames, the same as the beginning if not looping */
+	DSPLUG_AUDIO_EVENT_LATENCY	= 4, /**< data.integers[0] is the total latency in frames of the plugins before this one */
+
+} DSPlug_AudioEventType;
+
+
+/****************************/
+
+/* MIDI EVENTS */
+
+/****************************/
+
+/* Status byte helpers */
+
+#define DSPLUG_MIDI_STATUS_TYPE_MASK	0xF0
+#define DSPLUG_MIDI_STATUS_CHANNEL_MASK	0x0F
+
+#define DSPLUG_MIDI_STATUS_NOTE_OFF	0x80
+#define DSPLUG_MIDI_STATUS_NOTE_ON	0x90
+#define DSPLUG_MIDI_STATUS_AFTERTOUCH	0xA0
+#define DSPLUG_MIDI_STATUS_CONTROLLER	0xB0
+#define DSPLUG_MIDI_STATUS_PROGRAM	0xC0
+#define DSPLUG_MIDI_STATUS_PRESSURE	0xD0
+#define DSPLUG_MIDI_STATUS_PITCH_BEND	0xE0
+
+/**
+ * Types of the events found in DSPLUG_EVENT_TYPE_MIDI port queues
+ */
+typedef enum {
+
+	/**
+	* Short MIDI message. data.bytes[0] is the status byte,
+	* data.bytes[1] and data.bytes[2] the data bytes.
+	*/
+	DSPLUG_MIDI_EVENT_MESSAGE	= 0,
+
+	/**
+	* System exclusive message, stored in the payload arena of the queue
+	* (see DSPlug_EventQueue_push_payload()), including the 0xF0 and 0xF7 bytes.
+	*/
+	DSPLUG_MIDI_EVENT_SYSEX		= 1,
+
+} DSPlug_MidiEventType;
+
+/**
+ * Batch layout for the MIDI events of a process cycle.
+ * Events are stored as parallel arrays (one entry per event, in frame order)
+ * instead of an array of events, so plugins can scan the status or data
+ * bytes of a whole cycle in a tight loop, several bytes at a time.
+ * The arrays are owned by the block, and can be read freely.
+ */
+typedef struct {
+
+	int count; /**< amount of events in the block */
+	int capacity; /**< maximum amount of events in the block */
+
+	int *frames; /**< frame offset of each event */
+	unsigned char *status; /**< status byte of each event */
+	unsigned char *data1; /**< first data byte of each event */
+	unsigned char *data2; /**< second data byte of each event */
+
+} DSPlug_MidiEventBlock;
+
+/**
+ *	Create a MIDI event block. This allocates memory, so it must NOT
+ *	be called from a realtime thread.
+ *	\param c capacity in events
+ *	\return a new MIDI event block, NULL on error
+ */
+
+DSPlug_MidiEventBlock * DSPlug_MidiEventBlock_create( int c );
+
+/**
+ *	Destroy a MIDI event block.
+ */
+
+void DSPlug_MidiEventBlock_destroy( DSPlug_MidiEventBlock * );
+
+/**
+ *	Remove all events from the block.
+ */
+
+void DSPlug_MidiEventBlock_clear( DSPlug_MidiEventBlock * );
+
+/**
+ *	Append a MIDI message at the end of the block.
+ *	\param f frame offset
+ *	\param s status byte
+ *	\param d1 first data byte
+ *	\param d2 second data byte
+ *	\return true if added, false if the block is full
+ */
+
+DSPlug_Boolean DSPlug_MidiEventBlock_add( DSPlug_MidiEventBlock *, int f, unsigned char s, unsigned char d1, unsigned char d2 );
+
+/**
+ *	Encode the pending events of a MIDI port queue into the block, popping
+ *	them from the queue (consumer side). Events are appended to the ones
+ *	already in the block. Events that are not DSPLUG_MIDI_EVENT_MESSAGE are
+ *	left in the queue, stopping the encoding.
+ *	\param q queue of a DSPLUG_EVENT_TYPE_MIDI port
+ *	\return amount of events encoded
+ */
+
+int DSPlug_MidiEventBlock_encode_queue( DSPlug_MidiEventBlock *, DSPlug_EventQueue *q );
+
+/**
+ *	Decode all the events of the block into a MIDI port queue, pushing
+ *	them (producer side). The block is left untouched.
+ *	\param q queue of a DSPLUG_EVENT_TYPE_MIDI port
+ *	\return amount of events decoded, less than the block count if the queue filled up
+ */
+
+int DSPlug_MidiEventBlock_decode_queue( DSPlug_MidiEventBlock *, DSPlug_EventQueue *q );
+
+/**
+ *	Find the next event whose status byte, masked, equals a value.
+ *	For example, mask DSPLUG_MIDI_STATUS_TYPE_MASK and value DSPLUG_MIDI_STATUS_NOTE_ON
+ *	finds note-ons on any channel. The status bytes are compared a machine word
+ *	at a time.
+ *	\param from index of the first event to check
+ *	\param m mask applied to the status byte
+ *	\param v value to compare the masked status byte with
+ *	\return index of the event, or -1 if none is found
+ */
+
+int DSPlug_MidiEventBlock_find_status( DSPlug_MidiEventBlock *, int from, unsigned char m, unsigned char v );
+
+/**
+ *	Find the next controller change event for a given controller number, on any channel.
+ *	\param from index of the first event to check
+ *	\param cc controller number
+ *	\return index of the event, or -1 if none is found
+ */
+
+int DSPlug_MidiEventBlock_find_controller( DSPlug_MidiEventBlock *, int from, unsigned char cc );
+
+
+#endif /* dsplug_event.h */
@@ -25,6 +25,8 @@
 
 #include "dsplug_types.h"
 #include "dsplug_plugin_caps.h"
+#include "dsplug_event.h"
+#include "dsplug_data_buffer.h"
 
 /****************************/
 
@@ -94,7 +96,8 @@ DSPlug_PluginCaps DSPlug_PluginLibrary_get_plugin_caps( DSPlug_PluginLibrary * ,
 DSPlug_PluginInstance * DSPlug_PluginLibrary_get_plugin_instance( DSPlug_PluginLibrary * , int i , int r, DSPlug_Boolean ui);
 
 /**
- *	Uninitialize a plugin. Call this when you dont need it anymore
+ *	Uninitialize a plugin. Call this when you dont need it anymore, the instance
+ *	pointer is freed with it
  *	WARNING: DONT CALL THIS IF ANOTHER THREAD IS STILL USING THE PLUGIN
  *	\param p plugin
  */
@@ -129,6 +132,9 @@ void DSPlug_PluginInstance_connect_audio_port( DSPlug_PluginInstance * , int i,
  *	If not, you can safely feed the same input event queue instance to
  *	many plugins, as they should not modify it. This is useful
  *	for connecting the mastertrack and audio master event queues.
+ *	Queues are created with DSPlug_EventQueue_create (see dsplug_event.h).
+ *	Input DSPLUG_EVENT_TYPE_AUDIO ports come connected to a queue filled
+ *	by the library (see TRANSPORT below), connecting NULL restores it.
  *
  *	\param i event port index
  *	\param q event queue channel
@@ -137,6 +143,22 @@ void DSPlug_PluginInstance_connect_audio_port( DSPlug_PluginInstance * , int i,
 void DSPlug_PluginInstance_connect_event_port( DSPlug_PluginInstance *, int i, DSPlug_EventQueue *q );
 /* connect input event queue */
 
+/**
+ *	Connect a numerical input control port to a buffer of audio rate modulation
+ *	(values from 0.0f to 1.0f, one per frame), such as the audio output of another
+ *	plugin. The buffer is read on every process(), instead of setting the port
+ *	per sample. If the plugin doesn't read modulation for the port (see
+ *	DSPlug_ControlPortCaps_has_modulation_input), the library sets it to the mean
+ *	of every processed block, when it differs from the last value set.
+ *	Call it from the process thread or while the instance is not processing,
+ *	as processing walks the list of modulated ports.
+ *
+ *	\param i control port index
+ *	\param b buffer to float values, NULL disconnects
+ */
+
+void DSPlug_PluginInstance_connect_control_port_modulation( DSPlug_PluginInstance *, int i, const float *b );
+
 
 /* SETTING UP CONTROL PORTS */
 
@@ -150,10 +172,103 @@ void DSPlug_PluginInstance_connect_event_port( DSPlug_PluginInstance *, int i, D
  */
 void DSPlug_PluginInstance_set_control_numerical_port( DSPlug_PluginInstance * , int i , float v );
 
+/**
+ *	Set a numerical value, selecting the port by musical part
+ *	(see DSPlug_PluginCaps_get_musical_part_port). This takes the same
+ *	time no matter how many ports or parts the plugin has.
+ *
+ *	\param n musical part
+ *	\param x port inside the part
+ *	\param v value as float, from 0.0f to 1.0f
+ */
+void DSPlug_PluginInstance_set_musical_part_numerical_port( DSPlug_PluginInstance * , int n, int x, float v );
+
+/**
+ *	Set many numerical values at once, for example when loading a preset.
+ *	All the ports are validated first, in a single pass, and nothing is set
+ *	if any of them is invalid. Then the plugin receives them in a single
+ *	call, if it supports it, or port by port otherwise.
+ *	If the ports support realtime, this can safely called on a RT-Thread
+ *
+ *	\param p array of control port indices, all of them must be numerical input ports
+ *	\param v array of values as float, from 0.0f to 1.0f
+ *	\param n amount of ports
+ */
+void DSPlug_PluginInstance_set_control_numerical_ports( DSPlug_PluginInstance * , const int *p , const float *v, int n );
+
+/* CHANGE TRACKING */
+
+/*
+	Every change to a control port, set by the host or notified by the
+	plugin (see DSPlug_Plugin_UI_value_changed_notify), is given the next
+	generation of the instance, and the port remembers it. Mirroring the
+	state of an instance then only needs the ports changed since the last
+	generation seen, without reading all of them. Generations wrap around,
+	zero is never given.
+*/
+
+/**
+ *	\return the generation of the last change of the instance, zero if nothing changed yet
+ */
+unsigned int DSPlug_PluginInstance_get_change_generation( DSPlug_PluginInstance * );
+
+/**
+ *	\param i control port index
+ *	\return the generation of the last change of the port, zero if it never changed
+ */
+unsigned int DSPlug_PluginInstance_get_control_port_generation( DSPlug_PluginInstance * , int i );
+
+/**
+ *	Get the control ports changed after a generation. Every port is listed
+ *	once, the cost depends on the amount of changes, not of ports, unless
+ *	so many happened that they are no longer remembered.
+ *	Can be called from any thread, while changes happen.
+ *
+ *	\param g generation already seen, zero for every port that ever changed
+ *	\param p array with room for all the control ports, to store the changed ones
+ *	\param r the generation covered, pass it as g on the next call
+ *	\return amount of ports stored
+ */
+int DSPlug_PluginInstance_get_changed_control_ports( DSPlug_PluginInstance * , unsigned int g, int *p, unsigned int *r );
+
+/* CONTROL MAILBOX */
+
+/*
+	Setting a numerical port calls into the plugin right away, on the thread
+	of the caller, which races with process() unless the plugin locks. The
+	mailbox avoids this: values are posted from any thread to a slot per
+	port and a dirty bit is set, without locks nor waits. At the beginning
+	of every process cycle, the dirty ports are set in a single pass on the
+	audio thread. Only the last value posted to a port before the cycle is
+	applied.
+*/
+
+/**
+ *	Enable or disable the control mailbox. It is disabled by default.
+ *	This allocates memory, so it must NOT be called from a realtime thread,
+ *	nor while other threads are posting.
+ *
+ *	\param e true to enable the mailbox
+ */
+void DSPlug_PluginInstance_set_control_mailbox( DSPlug_PluginInstance * , DSPlug_Boolean e );
+
+/**
+ *	Post a numerical value to an input port, to be set at the beginning of
+ *	the next process cycle. Can be called from any thread. The mailbox must
+ *	be enabled.
+ *
+ *	\param i control port index
+ *	\param v value as float, from 0.0f to 1.0f
+ */
+void DSPlug_PluginInstance_post_control_numerical_port( DSPlug_PluginInstance * , int i , float v );
+
 /**
  *	Set a string value.
  *	This is ignored on output ports.
  *	If the port supports realtime, this can safely called on a RT-Thread
+ *	Ports whose value is kept by the library (see DSPlug_ControlPortCreation_create_string_managed)
+ *	never allocate, nor wait for the plugin. The plugin sees the new value
+ *	from the next process cycle. Set them from one thread at a time.
  *
  *	\param i control port index
  *	\param s constant pointer to a C-String, the plugin is not expected to keep it
@@ -171,6 +286,27 @@ void DSPlug_PluginInstance_set_control_string_port( DSPlug_PluginInstance * , in
  */
 void DSPlug_PluginInstance_set_control_data_port( DSPlug_PluginInstance * , int i , const void * d, int l );
 
+/**
+ *	Set the data of an asynchronous data port (see DSPlug_ControlPortCaps_is_data_async).
+ *	Call it from a worker thread, never the realtime one: the plugin builds its
+ *	object from the data here, and it's swapped in at the beginning of the next
+ *	process cycle, without blocking it. Only one thread may set a given port at
+ *	a time. Replaced objects are freed by DSPlug_PluginInstance_collect_retired_data.
+ *
+ *	\param i control port index
+ *	\param d data pointer, the plugin is not expected to keep it
+ *	\param l data length in bytes
+ */
+void DSPlug_PluginInstance_set_control_data_port_async( DSPlug_PluginInstance * , int i , const void * d, int l );
+
+/**
+ *	Free the objects of asynchronous data ports that were replaced by newer
+ *	ones, and replaced automation lanes. A port (or the automation) doesn't
+ *	take a new object until its replaced one is freed, so call this
+ *	periodically (or after setting data) from a non realtime thread.
+ */
+void DSPlug_PluginInstance_collect_retired_data( DSPlug_PluginInstance * );
+
 /**
  *	Get a numerical value from the port, from 0 to 1
  *	This is ignored on input ports.
@@ -197,6 +333,8 @@ char * DSPlug_PluginInstance_get_control_string_port( DSPlug_PluginInstance * ,
  *	Get a string value. The max length of this string is predetermined by the plugin
  *	This is ignored on output ports.
  *	You must use this function instead of the above one when the ports are realtime.
+ *	Ports kept by the library return the last value set, so call it from
+ *	the thread that sets them.
  *
  *	\param i control port index
  *	\param s pointer to a char buffer of size specified in: DSPlug_PluginInstance_get_control_string_port_realtime_max_length
@@ -229,13 +367,35 @@ char * DSPlug_PluginInstance_get_control_string_port( DSPlug_PluginInstance * ,
  */
 void DSPlug_PluginInstance_get_control_port_data( DSPlug_PluginInstance * , int i , void ** d, int * l );
 
+/**
+ *	Get a data port as a reference counted, immutable buffer (see
+ *	dsplug_data_buffer.h). If the plugin supports it, this is the data the
+ *	plugin holds, not a copy, so reading large data ports repeatedly (saving
+ *	state, inspecting it on a UI) costs nothing. Otherwise the data is copied
+ *	into a new buffer.
+ *	WARNING THIS FUNCTION CANT BE CALLED ON A REALTIME THREAD!
+ *
+ *	\param i control port index
+ *	\return a buffer, release it with DSPlug_DataBuffer_release, or NULL on error
+ */
+DSPlug_DataBuffer * DSPlug_PluginInstance_get_control_port_data_buffer( DSPlug_PluginInstance * , int i );
+
+
+/* UI NOTIFICATIONS */
+
+/*
+	When a port changes inside the plugin (see DSPlug_Plugin_UI_value_changed_notify),
+	the library only sets a dirty bit for it, from whatever thread the plugin
+	is on. The UI thread polls the changes, at frame rate for example, and
+	gets every changed port once, no matter how many times it changed.
+*/
+
+#define DSPLUG_UI_CHANGES_DISPATCH_CHUNK 64
 
 /**
  *	Set a callback to be called when an output/bidi control port has changed inside the plugin.
- *	If the output control port is realtime enabled, then this method may have been
- *      called from the RT-Thread, so apply the usual cautions to it for RT-Thread Programming.
- *      may use this for saving their configuration in binary
- *	format.
+ *	It is called from DSPlug_PluginInstance_dispatch_UI_changes, on the thread
+ *	that calls it, never on the realtime thread.
  *	This is ignored on input ports.
  *	WARNING THIS FUNCTION CANT BE CALLED ON A REALTIME THREAD!
  *
@@ -245,6 +405,23 @@ void DSPlug_PluginInstance_get_control_port_data( DSPlug_PluginInstance * , int
  */
 void DSPlug_PluginInstance_set_UI_changed_control_port_callback( DSPlug_PluginInstance * , int i , void (*c)(int, void *) , void * u);
 
+/**
+ *	Take the ports that changed since the last call, clearing them.
+ *	If there are more than fit, the rest are returned on the next call.
+ *	Can be called from any thread, but only from one at a time.
+ *
+ *	\param p array to store the changed control port indices
+ *	\param n size of the array
+ *	\return amount of ports stored
+ */
+int DSPlug_PluginInstance_drain_UI_changes( DSPlug_PluginInstance * , int *p, int n );
+
+/**
+ *	Drain the changed ports, calling the callback of each one
+ *	(see DSPlug_PluginInstance_set_UI_changed_control_port_callback).
+ */
+void DSPlug_PluginInstance_dispatch_UI_changes( DSPlug_PluginInstance * );
+
 
 /****************************/
 
@@ -262,6 +439,142 @@ void DSPlug_PluginInstance_set_UI_changed_control_port_callback( DSPlug_PluginIn
 
 void DSPlug_PluginInstance_process( DSPlug_PluginInstance * , int f );
 
+/* SAMPLE ACCURATE AUTOMATION */
+
+/**
+ *	Enable or disable sub-block splitting. When enabled, the block passed to
+ *	DSPlug_PluginInstance_process_control_changes is split into smaller
+ *	blocks at the frame offsets of the control changes, so the changes happen
+ *	at the exact frame even if the plugin knows nothing about events.
+ *	This is disabled by default.
+ *	Changes closer than m frames to the previous split, or to the end of the
+ *	block, are moved (at most m-1 frames) to avoid calling process() for
+ *	tiny blocks.
+ *
+ *	\param e true to enable splitting
+ *	\param m minimum amount of frames for a sub-block, 1 or more
+ */
+
+void DSPlug_PluginInstance_set_sub_block_splitting( DSPlug_PluginInstance * , DSPlug_Boolean e, int m );
+
+/**
+ *	Process a given amount of frames while applying a list of numerical
+ *	control port changes. If sub-block splitting is enabled, the processing
+ *	is split at the change offsets and the audio port buffers are offset
+ *	for each sub-block. Otherwise all changes are applied before processing.
+ *	Event ports are NOT split, event frames stay relative to the full block.
+ *
+ *	\param f amount of frames to process
+ *	\param c array of control changes, sorted by frame
+ *	\param n amount of control changes
+ */
+
+void DSPlug_PluginInstance_process_control_changes( DSPlug_PluginInstance * , int f, const DSPlug_ControlChange *c, int n );
+
+
+/* AUTOMATION */
+
+#define DSPLUG_AUTOMATION_MAX_RENDER_FRAMES 4096
+
+/*
+	The library can own the automation of numerical input ports, as lanes
+	of breakpoints over the transport position (see TRANSPORT below). All
+	the lanes of an instance are evaluated together at the beginning of
+	every processed block, or sub-block (see DSPlug_PluginInstance_process_control_changes).
+	Ports that read modulation (see DSPlug_ControlPortCaps_has_modulation_input)
+	receive a value per frame as their modulation buffer, for blocks of up to
+	DSPLUG_AUTOMATION_MAX_RENDER_FRAMES, the rest are set in a single batch,
+	only when their value changes (smoothing still applies).
+	Lanes can be edited while the instance is processing, from a non realtime
+	thread. Every edit builds a new copy of the lanes, which is swapped in at
+	the beginning of the next process cycle, and the replaced lanes are freed
+	by DSPlug_PluginInstance_collect_retired_data. Only one thread may edit the
+	automation of an instance at a time.
+*/
+
+/**
+ *	Set the automation lane of a numerical input port, replacing the previous one.
+ *	This allocates memory, so it must NOT be called from a realtime thread.
+ *	The lane is played from the next process cycle on.
+ *
+ *	\param i control port index
+ *	\param p array of breakpoints, sorted by frame, it is copied
+ *	\param n amount of breakpoints, zero removes the lane
+ *	\return true if the lane was set
+ */
+
+DSPlug_Boolean DSPlug_PluginInstance_set_automation_lane( DSPlug_PluginInstance * , int i, const DSPlug_AutomationPoint *p, int n );
+
+/**
+ *	Remove all the automation lanes, from the next process cycle on.
+ */
+
+void DSPlug_PluginInstance_clear_automation( DSPlug_PluginInstance * );
+
+
+/* TRANSPORT */
+
+/*
+	The library sends the transport state and the upstream latency to the
+	DSPLUG_EVENT_TYPE_AUDIO input ports of the instance at the beginning of
+	every process cycle (see DSPlug_AudioEventType in dsplug_event.h). The
+	position advances by the processed frames while playing, wrapping around
+	the loop, so the host only needs to call these when the state changes.
+*/
+
+/**
+ *	Set the transport position.
+ *	\param p position in frames
+ */
+
+void DSPlug_PluginInstance_set_transport_position( DSPlug_PluginInstance * , double p );
+
+/**
+ *	\return the transport position in frames for the next process cycle
+ */
+
+double DSPlug_PluginInstance_get_transport_position( DSPlug_PluginInstance * );
+
+/**
+ *	Start or stop the transport. It is stopped by default.
+ *	\param p true if playing
+ */
+
+void DSPlug_PluginInstance_set_transport_playing( DSPlug_PluginInstance * , DSPlug_Boolean p );
+
+/**
+ *	Set the loop points of the transport. Looping is disabled if the end
+ *	is not after the beginning, which is the default.
+ *	\param b loop beginning in frames
+ *	\param e loop end in frames
+ */
+
+void DSPlug_PluginInstance_set_transport_loop( DSPlug_PluginInstance * , double b, double e );
+
+/**
+ *	Set the total latency of the plugins feeding this instance, usually the
+ *	sum of their DSPlug_PluginInstance_get_output_delay().
+ *	\param l latency in frames
+ */
+
+void DSPlug_PluginInstance_set_upstream_latency( DSPlug_PluginInstance * , int l );
+
+
+/* EVENT RECORDING */
+
+/**
+ *	Record the input events of the instance. At the beginning of every
+ *	process cycle, the events that arrived to its connected input event
+ *	ports since the previous cycle are written to the recorder, without
+ *	removing them, so events a plugin keeps queued are recorded once.
+ *	Payloads are recorded with their events. Events generated by the
+ *	library (transport) are not recorded.
+ *
+ *	\param r event recorder, NULL to stop recording
+ */
+
+void DSPlug_PluginInstance_set_event_recorder( DSPlug_PluginInstance * , DSPlug_EventRecorder *r );
+
 
 /* RESETTING THE STATE */
 
@@ -277,6 +590,333 @@ void DSPlug_PluginInstance_process( DSPlug_PluginInstance * , int f );
 void DSPlug_PluginInstance_reset( DSPlug_PluginInstance * );
 
 
+/* STATE SNAPSHOTS */
+
+/*
+	The values of all the numerical, string and data input ports can be
+	saved to a single binary snapshot, and loaded back. Every port is
+	stored by its full path and name (see DSPlug_PluginCaps_find_port),
+	so snapshots survive plugin versions that add, remove or reorder ports,
+	ports that are not found are skipped. The snapshot is versioned, and
+	every entry is length prefixed, in native byte order.
+*/
+
+/**
+ *	Save the state of all the input control ports.
+ *	WARNING THIS FUNCTION CANT BE CALLED ON A REALTIME THREAD!
+ *
+ *	\param l pointer to a variable that will be set with the length of the snapshot
+ *	\return the snapshot, the host is in charge of freeing it, or NULL on error
+ */
+
+void * DSPlug_PluginInstance_save_state( DSPlug_PluginInstance * , int *l );
+
+/**
+ *	Load a snapshot. The ports are set directly from the buffer, strings and
+ *	data are passed to the plugin pointing inside it, and numerical ports are
+ *	set in a single batch, so nothing is allocated. If a port is in the
+ *	snapshot more than once, the last entry wins. The whole snapshot is
+ *	validated before setting anything. Asynchronous data ports are set with
+ *	DSPlug_PluginInstance_set_control_data_port_async, so loading a snapshot
+ *	of a plugin that has them is done from a worker thread.
+ *
+ *	\param b snapshot, as returned by DSPlug_PluginInstance_save_state
+ *	\param l length of the snapshot in bytes
+ *	\return true if the snapshot was valid and loaded
+ */
+
+DSPlug_Boolean DSPlug_PluginInstance_load_state( DSPlug_PluginInstance * , const void *b, int l );
+
+/**
+ *	Load a snapshot from a file, it is mapped into memory and loaded
+ *	in place (see DSPlug_PluginInstance_load_state).
+ *
+ *	\param p path to the file, which contains a saved snapshot as is
+ *	\return true if the snapshot was valid and loaded
+ */
+
+DSPlug_Boolean DSPlug_PluginInstance_load_state_file( DSPlug_PluginInstance * , const char *p );
+
+
+/****************************/
+
+/* PRESET MORPHING */
+
+/****************************/
+
+#define DSPLUG_PRESET_MORPH_MAX_SNAPSHOTS 64
+
+/*
+	A preset morph holds the numerical input ports of many state snapshots
+	of an instance, and blends them with a set of weights, for crossfading
+	between presets. The values are kept as one contiguous row per snapshot,
+	so a blend is a few tight loops over arrays instead of a call per port.
+	Integer ports are rounded to their steps, enumerated integer ports take
+	the value of the snapshot with the largest weight, and bool ports are
+	true when the blend is 0.5 or more.
+*/
+
+/**
+ *	Create a preset morph for an instance. All the snapshots begin as the
+ *	current values of the instance.
+ *	WARNING THIS FUNCTION CANT BE CALLED ON A REALTIME THREAD!
+ *
+ *	\param i plugin instance
+ *	\param n amount of snapshots, up to DSPLUG_PRESET_MORPH_MAX_SNAPSHOTS
+ *	\return a preset morph, or NULL on error
+ */
+
+DSPlug_PresetMorph * DSPlug_PresetMorph_create( DSPlug_PluginInstance *i, int n );
+void DSPlug_PresetMorph_destroy( DSPlug_PresetMorph * );
+
+/**
+ *	Fill a snapshot from a state snapshot (see DSPlug_PluginInstance_save_state).
+ *	Ports missing from it take the current values of the instance.
+ *	WARNING THIS FUNCTION CANT BE CALLED ON A REALTIME THREAD!
+ *
+ *	\param s snapshot index
+ *	\param b state snapshot
+ *	\param l length of the state snapshot in bytes
+ *	\return true if the state snapshot was valid
+ */
+
+DSPlug_Boolean DSPlug_PresetMorph_set_snapshot( DSPlug_PresetMorph * , int s, const void *b, int l );
+
+/**
+ *	Fill a snapshot with the current values of the instance.
+ *	\param s snapshot index
+ */
+
+void DSPlug_PresetMorph_capture_snapshot( DSPlug_PresetMorph * , int s );
+
+/**
+ *	Blend the snapshots and set the result to the instance. Nothing is
+ *	allocated, so if the ports are realtime safe this can be called on a
+ *	RT-Thread. Weights are used as given, they usually add up to 1.
+ *
+ *	\param w array of weights, one per snapshot
+ *	\param m true to post the values to the control mailbox (it must be enabled), so this can be called from any thread, false to set them right away in a single batch
+ */
+
+void DSPlug_PresetMorph_apply( DSPlug_PresetMorph * , const float *w, DSPlug_Boolean m );
+
+
+/****************************/
+
+/* TEMPO MAP */
+
+/****************************/
+
+/*
+	The tempo map is a host side object that keeps the tempo changes of a
+	song, and converts between frames and beats in constant time by using
+	lookup tables (logarithmic in the amount of tempo changes sharing a table
+	entry, when they are very dense). Tables are only rebuilt from the first modified tempo
+	change onwards. A single tempo map can feed the mastertrack ports of
+	any amount of plugin instances, so they dont need to integrate the tempo
+	curve themselves. Positions are in frames since the beginning of the song,
+	as doubles, so long songs dont overflow.
+	Modifying the tempo map allocates memory, so it must NOT be done from
+	a realtime thread. Lookups and event generation are realtime safe, as
+	long as they dont happen while the map is being modified.
+*/
+
+/**
+ *	Create a tempo map with a constant tempo, in 4/4 and C major.
+ *	\param r sampling rate, used to convert frames to time
+ *	\param t tempo in beats per minute
+ *	\return a new tempo map, NULL on error
+ */
+
+DSPlug_TempoMap * DSPlug_TempoMap_create( float r, double t );
+
+/**
+ *	Destroy a tempo map.
+ */
+
+void DSPlug_TempoMap_destroy( DSPlug_TempoMap * );
+
+/**
+ *	Set the tempo from a given frame onwards, until the next tempo change.
+ *	If there is already a tempo change at that frame, it is replaced.
+ *	\param f song frame, zero changes the initial tempo
+ *	\param t tempo in beats per minute
+ */
+
+void DSPlug_TempoMap_set_tempo( DSPlug_TempoMap * , double f, double t );
+
+/**
+ *	Remove all tempo changes, leaving a constant tempo.
+ *	\param t tempo in beats per minute
+ */
+
+void DSPlug_TempoMap_clear( DSPlug_TempoMap * , double t );
+
+/**
+ *	Set the time signature, sent to mastertrack ports.
+ *	\param n numerator (beats per bar)
+ *	\param d denominator (beat unit)
+ */
+
+void DSPlug_TempoMap_set_time_signature( DSPlug_TempoMap * , int n, int d );
+
+/**
+ *	Set the song key, sent to mastertrack ports.
+ *	\param k root note, from 0 (C) to 11 (B)
+ *	\param m true if the key is minor
+ */
+
+void DSPlug_TempoMap_set_key( DSPlug_TempoMap * , int k, DSPlug_Boolean m );
+
+/**
+ *	Set up to which frame the lookup tables cover the song. Lookups past
+ *	this still work, but take logarithmic time. By default, tables cover
+ *	the first ten minutes.
+ *	\param f length of the song in frames
+ */
+
+void DSPlug_TempoMap_set_lookup_length( DSPlug_TempoMap * , double f );
+
+/**
+ *	\param f song frame
+ *	\return the tempo at a given frame, in beats per minute
+ */
+
+double DSPlug_TempoMap_get_tempo( DSPlug_TempoMap * , double f );
+
+/**
+ *	\param f song frame
+ *	\return the song position in beats at a given frame
+ */
+
+double DSPlug_TempoMap_frame_to_beat( DSPlug_TempoMap * , double f );
+
+/**
+ *	\param b song position in beats
+ *	\return the song frame at which a given beat happens
+ */
+
+double DSPlug_TempoMap_beat_to_frame( DSPlug_TempoMap * , double b );
+
+/**
+ *	Push the mastertrack events for a process cycle into a queue
+ *	(producer side). See DSPlug_MastertrackEventType for what is sent.
+ *	\param q queue connected to DSPLUG_EVENT_TYPE_MASTERTRACK ports
+ *	\param f song frame at which the cycle begins
+ *	\param l length of the cycle in frames
+ *	\return amount of events pushed, less than expected if the queue filled up
+ */
+
+int DSPlug_TempoMap_push_cycle_events( DSPlug_TempoMap * , DSPlug_EventQueue *q, double f, int l );
+
+
+/****************************/
+
+/* EVENT RECORDING AND REPLAY */
+
+/****************************/
+
+/*
+	Input events can be recorded to a file and replayed later through the
+	same plugin, for benchmarking and regression testing with identical
+	input. The file is a small header followed by fixed size records (a
+	cycle marker with the amount of frames, then the events of the cycle),
+	in native byte order, so it is only meant to be replayed on the same
+	kind of machine. The player maps the file into memory and pushes the
+	records as they are, so the replayed events are bit-exact and nothing
+	needs parsing. Payloads of events (see DSPlug_EventQueue_push_payload)
+	are stored after their events, and pushed again with them.
+	Recording writes to the file from the process thread, so it is not
+	realtime safe. Replaying is, once the player is open.
+*/
+
+/**
+ *	Create an event recorder, truncating the file.
+ *	\param p file path
+ *	\return a new event recorder, NULL on error
+ */
+
+DSPlug_EventRecorder * DSPlug_EventRecorder_create( const char *p );
+
+/**
+ *	Destroy the recorder, closing the file. Make sure no instance uses it anymore.
+ */
+
+void DSPlug_EventRecorder_destroy( DSPlug_EventRecorder * );
+
+/**
+ *	Begin a new cycle. This is done automatically for instances recording
+ *	with DSPlug_PluginInstance_set_event_recorder, hosts only need it to
+ *	write files by themselves.
+ *	\param f amount of frames of the cycle
+ */
+
+void DSPlug_EventRecorder_begin_cycle( DSPlug_EventRecorder * , int f );
+
+/**
+ *	Record an event in the current cycle.
+ *	\param p event port index of the instance
+ *	\param ev event
+ */
+
+void DSPlug_EventRecorder_record_event( DSPlug_EventRecorder * , int p, const DSPlug_Event *ev );
+
+/**
+ *	Record an event carrying a payload in the current cycle.
+ *	It is replayed with DSPlug_EventQueue_push_payload, so the queue
+ *	it is replayed to needs a payload arena.
+ *	\param p event port index of the instance
+ *	\param ev event
+ *	\param payload payload of the event
+ *	\param size size of the payload in bytes, zero for none
+ */
+
+void DSPlug_EventRecorder_record_payload_event( DSPlug_EventRecorder * , int p, const DSPlug_Event *ev, const void *payload, int size );
+
+/**
+ *	\return amount of cycles recorded so far
+ */
+
+int DSPlug_EventRecorder_get_cycle_count( DSPlug_EventRecorder * );
+
+/**
+ *	Open a file written by an event recorder.
+ *	\param p file path
+ *	\return a new event player, NULL on error
+ */
+
+DSPlug_EventPlayer * DSPlug_EventPlayer_open( const char *p );
+
+/**
+ *	Close the player, unmapping the file.
+ */
+
+void DSPlug_EventPlayer_close( DSPlug_EventPlayer * );
+
+/**
+ *	\return amount of cycles in the file
+ */
+
+int DSPlug_EventPlayer_get_cycle_count( DSPlug_EventPlayer * );
+
+/**
+ *	Go back to the first cycle.
+ */
+
+void DSPlug_EventPlayer_rewind( DSPlug_EventPlayer * );
+
+/**
+ *	Replay the next cycle: push its events to the queues connected to the
+ *	event ports of the instance, then process as many frames as the cycle had.
+ *	Events for unconnected ports are skipped. The player is the producer of
+ *	those queues, it resets their payload arenas when they are empty.
+ *	\param i plugin instance, the same plugin the file was recorded with
+ *	\return true if a cycle was processed, false when the file is over
+ */
+
+DSPlug_Boolean DSPlug_EventPlayer_process_cycle( DSPlug_EventPlayer * , DSPlug_PluginInstance *i );
+
+
 /*******************/
 
 /* MISCELANEOUS	 */
@@ -24,6 +24,8 @@
 
 #include "dsplug_types.h"
 #include "dsplug_plugin_caps.h"
+#include "dsplug_event.h"
+#include "dsplug_data_buffer.h"
 
 /**************************
 * Plugin Library Creation *
@@ -184,8 +186,9 @@ void DSPlug_PluginCreation_add_audio_port( DSPlug_PluginCreation * , DSPlug_Plug
  * \param name Name of the port, this is UNIQUE for all audio ports
  * \param path UNIX-Like Path of the port, for example "/" (global value), "/filter" (part of a filter) "/oscilA" (Part of oscillator A"). "/" is automatically prepended to any value you pass. The same way, "/" is removed from the end of a sublocation. So passing "" and "/" , or "filter", "/filter", "filter/" and "/filter/" are all the same.
  * \param evt Type of the event (check available types)
+ * \param c Capacity hint, the amount of events the port may need to receive (or send) in a single cycle. Hosts should connect a queue at least this big. Zero means no preference, values above DSPLUG_EVENT_QUEUE_MAX_CAPACITY are clamped to it.
  */
-void DSPlug_PluginCreation_add_event_port( DSPlug_PluginCreation * , DSPlug_PlugType plug, const char *label, const char *name , const char *path, DSPlug_EventType evt );
+void DSPlug_PluginCreation_add_event_port( DSPlug_PluginCreation * , DSPlug_PlugType plug, const char *label, const char *name , const char *path, DSPlug_EventType evt, int c );
 
 /**
  * Add a control port to the plugin. If the port plug is if of type input,
@@ -260,6 +263,34 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 
  DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_string_realtime( void (*set_cbk)(DSPlug_Plugin , int, const char*) ,  void (*get_cbk)(DSPlug_Plugin , int, char*) , int maxlen );
 
+/**
+ * Instance a control port creation object. For the specific type of port.
+ * The library keeps the value of the port, so the plugin needs no callbacks
+ * and setting it never allocates: every port has three buffers of maxlen+1
+ * characters, the host writes into a free one while the plugin reads
+ * another, and the last one set is swapped in at the beginning of every
+ * process cycle. Longer strings are clipped. The port is realtime.
+ * The plugin reads it with DSPlug_Plugin_get_control_port_string.
+ *
+ * \param maxlen max length of the string, if you set 0, it defaults to DSPLUG_STRING_PARAM_MAX_LEN
+ * \return a Control Port Creation instance.
+ */
+
+DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_string_managed( int maxlen );
+
+/**
+ * Add a known value to a managed string port (see
+ * DSPlug_ControlPortCreation_create_string_managed), for enum-like strings.
+ * When the port is set to one of these, the plugin can compare its id
+ * (see DSPlug_Plugin_get_control_port_string_option) instead of the string.
+ * Ids are given in order, starting at zero.
+ *
+ * \param s the string, not longer than the max length of the port
+ * \return the id of the string, -1 on error
+ */
+
+int DSPlug_ControlPortCreation_add_string_option(DSPlug_ControlPortCreation *, const char *s);
+
  /**
  * Instance a control port creation object. For the specific type of port.
  * Output data ports cant be realtime.
@@ -313,6 +344,57 @@ void DSPlug_ControlPortCreation_set_hidden(DSPlug_ControlPortCreation *);
  */
 void DSPlug_ControlPortCreation_set_musical_part(DSPlug_ControlPortCreation *, int p_part);
 
+/**
+ * Make the library smooth the values of a numerical port, so the plugin
+ * doesn't have to. The set callback still receives the new (target) value
+ * right away, while inside process() the plugin obtains the smoothed values
+ * of the block with DSPlug_Plugin_get_control_ramp or
+ * DSPlug_Plugin_render_control_ramp. The library advances the ramps after
+ * every process() call. The first value ever set is not smoothed.
+ *
+ * \param m smoothing mode
+ * \param t time in seconds, its meaning depends on the mode
+ */
+void DSPlug_ControlPortCreation_set_smoothing(DSPlug_ControlPortCreation *, DSPlug_SmoothingMode m, float t);
+
+/**
+ * Declare that the plugin can read audio rate modulation of a numerical port,
+ * with DSPlug_Plugin_get_control_port_modulation_buffer. Hosts may connect a
+ * buffer of values to any numerical input port, if the plugin doesn't declare
+ * this, the library decimates the buffer to one value per block (its mean)
+ * and sets the port as usual.
+ *
+ * \param e true if the plugin reads the modulation buffer
+ */
+void DSPlug_ControlPortCreation_set_modulation_input(DSPlug_ControlPortCreation *, DSPlug_Boolean e);
+
+/**
+ * Make a data port asynchronous. Large data (impulse responses, sample maps,
+ * model weights) is then turned into the object the plugin uses on a host
+ * worker thread, by prepare_cbk, which may allocate and take as long as it
+ * needs. The library swaps the new object in at the beginning of the next
+ * process cycle, so process() never waits for it and the plugin needs no
+ * locking, and the replaced object is given to release_cbk off the realtime
+ * thread. Inside process(), the object is obtained with
+ * DSPlug_Plugin_get_control_port_data_object.
+ *
+ * \param prepare_cbk builds the object from the data, which it must not keep
+ * \param release_cbk frees an object
+ */
+void DSPlug_ControlPortCreation_set_data_async(DSPlug_ControlPortCreation *, void * (*prepare_cbk)(DSPlug_Plugin , int, const void *, int), void (*release_cbk)(DSPlug_Plugin , int, void *));
+
+/**
+ * Let the host read a data port without copying it. The callback returns
+ * a new reference (see DSPlug_DataBuffer_retain) to an immutable buffer with
+ * the current data of the port, which the host releases when done. Usually
+ * the plugin keeps the buffer of its current data, and only makes a new one
+ * when the data changes. Without this, reading the port goes through the get
+ * callback given to DSPlug_ControlPortCreation_create_data, and is copied.
+ *
+ * \param c callback returning a new reference to the data
+ */
+void DSPlug_ControlPortCreation_set_data_buffer_callback(DSPlug_ControlPortCreation *, DSPlug_DataBuffer * (*c)(DSPlug_Plugin , int));
+
 /**
  * Set the pointer to the process function. This function is called
  * by the host to process a given chunk of data. Since realtime-capable hosts
@@ -366,6 +448,16 @@ void DSPlug_PluginCreation_set_reset_callback( DSPlug_PluginCreation * , void (*
  */
 void DSPlug_PluginCreation_set_output_delay_callback( DSPlug_PluginCreation * ,int (*get_output_delay_callback)(DSPlug_Plugin *) );
 
+/**
+ * When the host sets many numerical ports at once (loading a preset, or the
+ * control mailbox of a cycle), the library calls this once with all of them,
+ * instead of calling the set callback of every port. The ports are already
+ * validated to be numerical input ports. It is not mandatory to implement,
+ * without it the set callbacks of the ports are called one by one.
+ * The callback receives the port indices, the values, and the amount of them.
+ */
+void DSPlug_PluginCreation_set_control_numerical_batch_callback( DSPlug_PluginCreation * , void (*c)(DSPlug_Plugin, const int *, const float *, int) );
+
 /*********
 * Plugin *
 **********/
@@ -420,13 +512,87 @@ DSPlug_EventQueue* DSPlug_Plugin_get_event_port_queue( DSPlug_Plugin , int p);
  */
 DSPlug_EventQueue** DSPlug_Plugin_get_event_port_queue_pointer( DSPlug_Plugin , int p);
 
+/**
+ * Begin merging the events of all the connected input event ports, in frame order.
+ * Only the ports whose queues got events take part in the merge, the others
+ * are skipped 32 at a time, so the cost depends mostly on the amount of events.
+ * Queues shared by many ports can only notify one of them, in the others
+ * they are looked at every time.
+ * Call this inside the process callback, then call DSPlug_Plugin_get_next_input_event
+ * until it returns false.
+ */
+void DSPlug_Plugin_begin_input_events( DSPlug_Plugin );
+
+/**
+ * Pop the earliest pending event among all the input event ports. Events with the
+ * same frame are returned in port order.
+ * \param ev pointer to where the event will be copied
+ * \param p pointer to where the port index of the event will be stored
+ * \return true if an event was popped, false when there are no more events
+ */
+DSPlug_Boolean DSPlug_Plugin_get_next_input_event( DSPlug_Plugin , DSPlug_Event *ev, int *p );
+
 /* Control */
 
 /**
- * The UI must call this function upon modification of a port that can edit
- * This is used mainly for speedup purposes.
- * Dont forget that you must not do any other than reading events from an input port, since it may be shared with another port or plugin
- * \return pointer to an event queue, for reading (an input) or writing (output port). a pointer to NULL if the host didnt connect the port. NULL if the port/channel doesnt exist
+ * Obtain the ramp of a smoothed numerical port for the block being processed.
+ * Ports without smoothing report a flat ramp at their last set value.
+ * \param p control port index
+ * \param r pointer to where the ramp will be stored
+ */
+void DSPlug_Plugin_get_control_ramp( DSPlug_Plugin , int p, DSPlug_ControlRamp *r );
+
+/**
+ * Write the smoothed values of a numerical port for the block being processed,
+ * one per frame. Cheaper than evaluating the ramp per sample in the plugin.
+ * \param p control port index
+ * \param b buffer for f floats
+ * \param f amount of frames, usually the one passed to process()
+ */
+void DSPlug_Plugin_render_control_ramp( DSPlug_Plugin , int p, float *b, int f );
+
+/**
+ * Obtain the audio rate modulation of a numerical port declared as
+ * modulation input, one value (from 0.0f to 1.0f) per frame of the
+ * block being processed. Only valid inside process().
+ * \param p control port index
+ * \return pointer to the values, or NULL if the host didn't connect a buffer
+ */
+const float * DSPlug_Plugin_get_control_port_modulation_buffer( DSPlug_Plugin , int p );
+
+/**
+ * Obtain the current object of an asynchronous data port (see
+ * DSPlug_ControlPortCreation_set_data_async). It doesn't change during
+ * a process() call.
+ * \param p control port index
+ * \return the object, or NULL if no data was set yet
+ */
+void * DSPlug_Plugin_get_control_port_data_object( DSPlug_Plugin , int p );
+
+/**
+ * Obtain the current value of a managed string port (see
+ * DSPlug_ControlPortCreation_create_string_managed). It doesn't change
+ * during a process() call.
+ * \param p control port index
+ * \return the string, owned by the library, NULL on error
+ */
+const char * DSPlug_Plugin_get_control_port_string( DSPlug_Plugin , int p );
+
+/**
+ * Obtain the id of the current value of a managed string port, as given
+ * by DSPlug_ControlPortCreation_add_string_option.
+ * \param p control port index
+ * \return the id, -1 if the value is not one of the options
+ */
+int DSPlug_Plugin_get_control_port_string_option( DSPlug_Plugin , int p );
+
+/**
+ * The plugin must call this function upon modification of a port that the
+ * UI may display. It only marks the port as changed, without locks nor
+ * calls into the host, so it is safe from any thread, including the
+ * realtime one. Many changes before the host looks are notified once
+ * (see DSPlug_PluginInstance_drain_UI_changes).
+ * \param p control port index
  */
 void DSPlug_Plugin_UI_value_changed_notify( DSPlug_Plugin , int p);
 
@@ -221,6 +221,46 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps , DSPlug_PluginConstant c)
 
  void DSPlug_PluginCaps_get_port_path( DSPlug_PluginCaps, DSPlug_PortType t, int i, char * s);
 
+/**
+  *	Find a port by its name, or by its full path and name, such as "/filter/cutoff"
+  *	(anything begining with "/" is taken as a full path). This uses an index built
+  *	when the plugin was added, so it's fast even for plugins with many ports, and it
+  *	should be preferred to looping over DSPlug_PluginCaps_get_port_name.
+  *	If many ports share a name, the first one is found.
+  *	\param t type of ports being accessed
+  *	\param s name or full path of the port
+  *	\return the port index, or -1 if not found
+ */
+
+ int DSPlug_PluginCaps_find_port( DSPlug_PluginCaps, DSPlug_PortType t, const char *s );
+
+/**
+  *	Control ports can belong to a musical part (see DSPlug_ControlPortCaps_get_music_part).
+  *	An index of the ports of every part is built when the plugin is added,
+  *	so the functions below don't loop over the ports.
+  *	\return the amount of musical parts, the highest part used plus one
+ */
+
+ int DSPlug_PluginCaps_get_musical_part_count( DSPlug_PluginCaps );
+
+/**
+  *	\param n musical part
+  *	\return the amount of control ports of the musical part
+ */
+
+ int DSPlug_PluginCaps_get_musical_part_port_count( DSPlug_PluginCaps, int n );
+
+/**
+  *	Obtain a control port of a musical part. The ports of every part are
+  *	numbered from zero, in the order they were added, so plugins that add
+  *	the same ports for every part have the same numbering in all of them.
+  *	\param n musical part
+  *	\param x port inside the part
+  *	\return the control port index, or -1 if not found
+ */
+
+ int DSPlug_PluginCaps_get_musical_part_port( DSPlug_PluginCaps, int n, int x );
+
 /**
   *	Get AUDIO port capabilities.
   *	\param i the audio port index, begining from zero
@@ -286,6 +326,14 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps , DSPlug_PluginConstant c)
 
  DSPlug_EventType DSPlug_EventPortCaps_get_event_type( DSPlug_EventPortCaps );
 
+/**
+  *	Get the amount of events the plugin expects the port to handle in a single
+  *	cycle. The queue connected to the port should be created at least this big.
+  *	\return capacity hint in events, 0 if the plugin has no preference
+ */
+
+ int DSPlug_EventPortCaps_get_capacity_hint( DSPlug_EventPortCaps );
+
  /****************************/
 
  /* CONTROL PORT CAPS */
@@ -419,6 +467,43 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps , DSPlug_PluginConstant c)
 
  DSPlug_Boolean DSPlug_ControlPortCaps_is_realtime_safe( DSPlug_ControlPortCaps );
 
+/**
+  *
+  *	Any numerical input port can be connected to a buffer of audio rate
+  *	modulation (see DSPlug_PluginInstance_connect_control_port_modulation).
+  *	Ports declared as modulation input are modulated per frame by the
+  *	plugin, the rest are set once per block by the library.
+  *	\return true if the plugin reads the modulation per frame
+ */
+
+ DSPlug_Boolean DSPlug_ControlPortCaps_has_modulation_input( DSPlug_ControlPortCaps );
+
+/**
+  *
+  *	Managed string ports may have a list of known values (the plugin
+  *	compares them by index), hosts can offer them as choices.
+  *	\return amount of known values, zero if none
+ */
+
+ int DSPlug_ControlPortCaps_get_string_option_count( DSPlug_ControlPortCaps );
+
+/**
+  *
+  *	\param i index of the known value
+  *	\return the known value, NULL on error
+ */
+
+ const char * DSPlug_ControlPortCaps_get_string_option( DSPlug_ControlPortCaps, int i );
+
+/**
+  *
+  *	Data ports can be asynchronous, the data is then meant to be set from a
+  *	worker thread, with DSPlug_PluginInstance_set_control_data_port_async.
+  *	\return true if the data port is asynchronous
+ */
+
+ DSPlug_Boolean DSPlug_ControlPortCaps_is_data_async( DSPlug_ControlPortCaps );
+
 /**
   *
   *	If a port has many MIDI event input ports, then you may want to
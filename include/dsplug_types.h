@@ -292,6 +292,78 @@ typedef enum {
 
 /* //////////////////////////////////////////////////////// */
 
+/* Numerical Control Port Smoothing */
+
+typedef enum {
+
+	DSPLUG_SMOOTHING_NONE		= 0, /**< Values are applied right away (default) */
+	DSPLUG_SMOOTHING_LINEAR		= 1, /**< Linear ramp at a constant rate, the time is what a ramp across the whole 0..1 range takes */
+	DSPLUG_SMOOTHING_EXPONENTIAL	= 2, /**< One-pole lowpass, the time is the time constant (63% of the way to the target) */
+	DSPLUG_SMOOTHING_FIXED_TIME	= 3, /**< Linear ramp that always takes the given time, no matter the distance to the target */
+
+} DSPlug_SmoothingMode;
+
+/**
+ * Describes the values a smoothed numerical port takes during the
+ * block being processed, so plugins can compute them in their own
+ * loops without a per-sample buffer. For frame n of the block (from 0):
+ *
+ *	linear modes: value = start + step*(n+1) while n < frames, target afterwards
+ *	exponential:  value = target + (start-target)*coefficient^(n+1)
+ */
+typedef struct {
+
+	DSPlug_SmoothingMode mode;
+	float start; /**< value right before the first frame */
+	float target; /**< value the port is moving to */
+	float step; /**< linear modes, increment per frame */
+	int frames; /**< linear modes, frames left until the target is reached */
+	float coefficient; /**< exponential mode, decay per frame */
+
+} DSPlug_ControlRamp;
+
+/* //////////////////////////////////////////////////////// */
+
+/* Timestamped Control Changes */
+
+/**
+ * A numerical control port change, scheduled at a given frame of
+ * the block being processed.
+ */
+typedef struct {
+
+	int frame; /**< Frame offset, relative to the beginning of the processed block */
+	int port; /**< Numerical control port index */
+	float value; /**< Value, from 0.0f to 1.0f */
+
+} DSPlug_ControlChange;
+
+/* //////////////////////////////////////////////////////// */
+
+/* Automation */
+
+typedef enum {
+
+	DSPLUG_AUTOMATION_HOLD		= 0, /**< Keep the value of the point until the next one */
+	DSPLUG_AUTOMATION_LINEAR	= 1, /**< Straight line to the next point */
+	DSPLUG_AUTOMATION_EXPONENTIAL	= 2, /**< Constant ratio per frame to the next point, for gains and frequencies */
+
+} DSPlug_AutomationShape;
+
+/**
+ * A breakpoint of an automation lane. The shape is the one of the
+ * segment that begins at this point.
+ */
+typedef struct {
+
+	double frame; /**< Transport position, in frames */
+	float value; /**< Value, from 0.0f to 1.0f */
+	DSPlug_AutomationShape shape;
+
+} DSPlug_AutomationPoint;
+
+/* //////////////////////////////////////////////////////// */
+
 /* Plugin Features */
 
 typedef enum {
@@ -408,6 +480,45 @@ typedef struct {
 	const void * _private; /**< No access to the internals are provided */
 } DSPlug_EventQueue;
 
+/**
+ * Data Buffer. Immutable, reference counted block of data.
+ */
+typedef struct {
+	const void * _private; /**< No access to the internals are provided */
+} DSPlug_DataBuffer;
+
+/**
+ * Tempo Map. Host side service that converts between frames and beats, and
+ * produces the events for mastertrack ports.
+ */
+typedef struct {
+	const void * _private; /**< No access to the internals are provided */
+} DSPlug_TempoMap;
+
+/**
+ * Event Recorder. Host side object that captures the input events
+ * of plugin instances into a file.
+ */
+typedef struct {
+	const void * _private; /**< No access to the internals are provided */
+} DSPlug_EventRecorder;
+
+/**
+ * Event Player. Host side object that replays a file written by an
+ * event recorder through a plugin instance.
+ */
+typedef struct {
+	const void * _private; /**< No access to the internals are provided */
+} DSPlug_EventPlayer;
+
+/**
+ * Preset morph, blends the numerical ports of many state snapshots
+ * for a plugin instance.
+ */
+typedef struct {
+	const void * _private; /**< No access to the internals are provided */
+} DSPlug_PresetMorph;
+
 /**
  * This object stores the capabilities of a given plugin.
  */
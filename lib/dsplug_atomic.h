@@ -0,0 +1,35 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DSPLUG_ATOMIC_H
+#define DSPLUG_ATOMIC_H
+
+/**
+ * Tiny set of atomic primitives used by the lock-free parts of the library.
+ * C89 has no notion of atomics, so these map to the GCC __sync builtins,
+ * which are full memory barriers. Porting to another compiler only
+ * requires redefining these.
+ */
+
+/* Shared indices are volatile, and ordered against the data they guard with this */
+#define DSPLUG_MEMORY_BARRIER() __sync_synchronize()
+
+#define DSPLUG_ATOMIC_FETCH_ADD(m_ptr,m_val) __sync_fetch_and_add(m_ptr,m_val)
+#define DSPLUG_ATOMIC_FETCH_OR(m_ptr,m_val) __sync_fetch_and_or(m_ptr,m_val)
+#define DSPLUG_ATOMIC_FETCH_AND(m_ptr,m_val) __sync_fetch_and_and(m_ptr,m_val)
+#define DSPLUG_ATOMIC_CAS(m_ptr,m_old,m_new) __sync_bool_compare_and_swap(m_ptr,m_old,m_new)
+
+#endif /* dsplug_atomic.h */
@@ -0,0 +1,268 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_automation.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#define DSPLUG_AUTOMATION_EXPONENTIAL_MIN 1e-4f /* exponential segments can't reach zero */
+
+DSPlug_AutomationPrivate * DSPlug_Automation_create(int max_lanes) {
+
+	DSPlug_AutomationPrivate *a = (DSPlug_AutomationPrivate*)malloc(sizeof(DSPlug_AutomationPrivate));
+
+	a->lane_count=0;
+	a->max_lanes=max_lanes;
+	a->ports=(int*)malloc(sizeof(int)*(max_lanes+1));
+	a->lanes=(DSPlug_AutomationLanePrivate*)malloc(sizeof(DSPlug_AutomationLanePrivate)*(max_lanes+1));
+	a->start=(double*)malloc(sizeof(double)*(max_lanes+1));
+	a->offset=(float*)malloc(sizeof(float)*(max_lanes+1));
+	a->slope=(float*)malloc(sizeof(float)*(max_lanes+1));
+	a->values=(float*)malloc(sizeof(float)*(max_lanes+1));
+	a->batch_ports=(int*)malloc(sizeof(int)*(max_lanes+1));
+	a->batch_values=(float*)malloc(sizeof(float)*(max_lanes+1));
+
+	return a;
+}
+
+void DSPlug_Automation_destroy(DSPlug_AutomationPrivate *a) {
+
+	int i;
+
+	for (i=0;i<a->lane_count;i++) {
+
+		free(a->lanes[i].points);
+		free(a->lanes[i].render_buffer);
+	}
+
+	free(a->ports);
+	free(a->lanes);
+	free(a->start);
+	free(a->offset);
+	free(a->slope);
+	free(a->values);
+	free(a->batch_ports);
+	free(a->batch_values);
+	free(a);
+}
+
+DSPlug_AutomationPrivate * DSPlug_Automation_copy(const DSPlug_AutomationPrivate *a) {
+
+	DSPlug_AutomationPrivate *copy = DSPlug_Automation_create(a->max_lanes);
+	int i;
+
+	for (i=0;i<a->lane_count;i++)
+		DSPlug_Automation_set_lane(copy,a->ports[i],a->lanes[i].points,a->lanes[i].count,a->lanes[i].render_frames);
+
+	return copy;
+}
+
+int DSPlug_Automation_find_lane(const DSPlug_AutomationPrivate *a, int port) {
+
+	int i;
+
+	for (i=0;i<a->lane_count;i++) {
+
+		if (a->ports[i]==port)
+			return i;
+	}
+
+	return -1;
+}
+
+void DSPlug_Automation_set_lane(DSPlug_AutomationPrivate *a, int port, const DSPlug_AutomationPoint *p, int n, int render_frames) {
+
+	int l=DSPlug_Automation_find_lane(a,port);
+	DSPlug_AutomationLanePrivate *lane;
+
+	if (l>=0) {
+
+		free(a->lanes[l].points);
+		free(a->lanes[l].render_buffer);
+
+		if (n==0) {
+
+			/* last lane takes its place */
+			a->lane_count--;
+			a->ports[l]=a->ports[a->lane_count];
+			a->lanes[l]=a->lanes[a->lane_count];
+			a->start[l]=a->start[a->lane_count];
+			a->offset[l]=a->offset[a->lane_count];
+			a->slope[l]=a->slope[a->lane_count];
+			return;
+		}
+	} else {
+
+		if (n==0)
+			return;
+
+		l=a->lane_count++;
+		a->ports[l]=port;
+	}
+
+	lane=&a->lanes[l];
+	lane->points=(DSPlug_AutomationPoint*)malloc(sizeof(DSPlug_AutomationPoint)*n);
+	memcpy(lane->points,p,sizeof(DSPlug_AutomationPoint)*n);
+	lane->count=n;
+	lane->range_begin=1; /* empty range, forces a search */
+	lane->range_end=0;
+	lane->exponential=DSPLUG_FALSE;
+	lane->render_buffer=(render_frames>0) ? (float*)malloc(sizeof(float)*render_frames) : NULL;
+	lane->render_frames=render_frames;
+	lane->sent_valid=DSPLUG_FALSE;
+}
+
+/* Find the segment of lane l at the position, unless it's the current one */
+static void DSPlug_Automation_seek(DSPlug_AutomationPrivate *a, int l, double position) {
+
+	DSPlug_AutomationLanePrivate *lane=&a->lanes[l];
+	const DSPlug_AutomationPoint *points=lane->points;
+	const DSPlug_AutomationPoint *from,*to;
+	float v0,v1;
+	int lo=0,hi=lane->count-1,mid,segment=-1;
+
+	if (position>=lane->range_begin && position<lane->range_end)
+		return;
+
+	/* last point at or before the position */
+	while (lo<=hi) {
+
+		mid=(lo+hi)/2;
+
+		if (points[mid].frame<=position) {
+			segment=mid;
+			lo=mid+1;
+		} else {
+			hi=mid-1;
+		}
+	}
+
+	lane->exponential=DSPLUG_FALSE;
+	a->slope[l]=0;
+
+	if (segment<0) { /* before the first point */
+
+		lane->range_begin=-DBL_MAX;
+		lane->range_end=points[0].frame;
+		a->start[l]=points[0].frame;
+		a->offset[l]=points[0].value;
+		return;
+	}
+
+	from=&points[segment];
+	lane->range_begin=from->frame;
+	a->start[l]=from->frame;
+	a->offset[l]=from->value;
+
+	if (segment==lane->count-1) { /* after the last point */
+
+		lane->range_end=DBL_MAX;
+		return;
+	}
+
+	to=&points[segment+1];
+	lane->range_end=to->frame;
+
+	switch (from->shape) {
+
+		case DSPLUG_AUTOMATION_LINEAR: {
+
+			a->slope[l]=(float)((to->value-from->value)/(to->frame-from->frame));
+		} break;
+		case DSPLUG_AUTOMATION_EXPONENTIAL: {
+
+			v0=(from->value<DSPLUG_AUTOMATION_EXPONENTIAL_MIN) ? DSPLUG_AUTOMATION_EXPONENTIAL_MIN : from->value;
+			v1=(to->value<DSPLUG_AUTOMATION_EXPONENTIAL_MIN) ? DSPLUG_AUTOMATION_EXPONENTIAL_MIN : to->value;
+			a->offset[l]=(float)log(v0);
+			a->slope[l]=(float)((log(v1)-log(v0))/(to->frame-from->frame));
+			lane->exponential=DSPLUG_TRUE;
+		} break;
+		default: {} /* hold */
+	}
+}
+
+void DSPlug_Automation_evaluate(DSPlug_AutomationPrivate *a, double position) {
+
+	float *values=a->values;
+	int count=a->lane_count;
+	int i;
+
+	for (i=0;i<count;i++)
+		DSPlug_Automation_seek(a,i,position);
+
+	for (i=0;i<count;i++)
+		values[i]=a->offset[i]+a->slope[i]*(float)(position-a->start[i]);
+
+	for (i=0;i<count;i++) {
+
+		if (a->lanes[i].exponential)
+			values[i]=(float)exp(values[i]);
+	}
+
+	for (i=0;i<count;i++)
+		values[i]=(values[i]<0) ? 0 : ((values[i]>1) ? 1 : values[i]);
+}
+
+const float * DSPlug_Automation_render(DSPlug_AutomationPrivate *a, int l, double position, int f) {
+
+	DSPlug_AutomationLanePrivate *lane=&a->lanes[l];
+	float *b=lane->render_buffer;
+	double pos;
+	float v,ratio,slope;
+	int k=0,n,j;
+
+	while (k<f) {
+
+		pos=position+k;
+		DSPlug_Automation_seek(a,l,pos);
+
+		/* frames until the segment ends */
+		n=f-k;
+		if (lane->range_end<position+f) {
+
+			n=(int)ceil(lane->range_end-pos);
+			if (n<1)
+				n=1;
+		}
+
+		v=a->offset[l]+a->slope[l]*(float)(pos-a->start[l]);
+		slope=a->slope[l];
+
+		if (lane->exponential) {
+
+			v=(float)exp(v);
+			ratio=(float)exp(slope);
+			for (j=0;j<n;j++) {
+				b[k+j]=v;
+				v*=ratio;
+			}
+		} else {
+
+			for (j=0;j<n;j++)
+				b[k+j]=v+slope*j;
+		}
+
+		k+=n;
+	}
+
+	for (j=0;j<f;j++)
+		b[j]=(b[j]<0) ? 0 : ((b[j]>1) ? 1 : b[j]);
+
+	return b;
+}
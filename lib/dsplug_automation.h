@@ -0,0 +1,71 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DSPLUG_AUTOMATION_H
+#define DSPLUG_AUTOMATION_H
+
+#include "dsplug_types.h"
+
+/*
+	Automation lanes of an instance. The current segment of every lane is
+	kept as value = offset + slope*(position-start), in separate arrays, so
+	all the lanes are evaluated together with one plain loop per array.
+	Exponential segments are lines in the log domain. Segments are only
+	searched again when the position leaves the current one.
+*/
+
+typedef struct {
+
+	DSPlug_AutomationPoint *points;
+	int count;
+
+	double range_begin; /* positions where the current segment is valid */
+	double range_end;
+	DSPlug_Boolean exponential;
+
+	float *render_buffer; /* a value per frame, for ports that read modulation, NULL otherwise */
+	int render_frames;
+	float sent; /* last value set to the port */
+	DSPlug_Boolean sent_valid;
+
+} DSPlug_AutomationLanePrivate;
+
+typedef struct {
+
+	int lane_count;
+	int max_lanes;
+	int *ports; /* control port of every lane */
+	DSPlug_AutomationLanePrivate *lanes;
+
+	double *start;
+	float *offset;
+	float *slope;
+	float *values; /* result of the last evaluation */
+
+	int *batch_ports; /* scratch, for setting the ports in a single batch */
+	float *batch_values;
+
+} DSPlug_AutomationPrivate;
+
+DSPlug_AutomationPrivate * DSPlug_Automation_create(int max_lanes);
+void DSPlug_Automation_destroy(DSPlug_AutomationPrivate *a);
+DSPlug_AutomationPrivate * DSPlug_Automation_copy(const DSPlug_AutomationPrivate *a); /* lanes only, evaluation starts over */
+void DSPlug_Automation_set_lane(DSPlug_AutomationPrivate *a, int port, const DSPlug_AutomationPoint *p, int n, int render_frames); /* n==0 removes the lane */
+int DSPlug_Automation_find_lane(const DSPlug_AutomationPrivate *a, int port);
+void DSPlug_Automation_evaluate(DSPlug_AutomationPrivate *a, double position);
+const float * DSPlug_Automation_render(DSPlug_AutomationPrivate *a, int lane, double position, int f);
+
+#endif
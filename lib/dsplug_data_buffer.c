@@ -0,0 +1,142 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_data_buffer.h"
+#include "dsplug_error_report.h"
+#include "dsplug_atomic.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+
+	volatile int refcount;
+
+	const void *data;
+	int length;
+
+	void (*free_callback)(const void *, void *); /* wrapped data only */
+	void *free_userdata;
+
+} DSPlug_DataBufferPrivate;
+
+/* The handle, the private part and (for copies) the data share one allocation */
+typedef struct {
+
+	DSPlug_DataBuffer handle;
+	DSPlug_DataBufferPrivate buffer;
+
+} DSPlug_DataBufferBlock;
+
+#define DSPLUG_DATA_BUFFER_BLOCK_SIZE ((sizeof(DSPlug_DataBufferBlock)+7)&~7) /* data begins aligned */
+
+
+DSPlug_DataBuffer * DSPlug_DataBuffer_create( const void *d, int l ) {
+
+	DSPlug_DataBufferBlock *block;
+
+	if (l<0 || (l>0 && !d)) {
+
+		DSPlug_report_error("API: DSPlug_DataBuffer_create: Invalid data or length");
+		return NULL;
+	}
+
+	block = (DSPlug_DataBufferBlock*)malloc(DSPLUG_DATA_BUFFER_BLOCK_SIZE+l);
+	memset(block,0,sizeof(DSPlug_DataBufferBlock));
+
+	if (l)
+		memcpy((char*)block+DSPLUG_DATA_BUFFER_BLOCK_SIZE,d,l);
+
+	block->buffer.refcount=1;
+	block->buffer.data=(char*)block+DSPLUG_DATA_BUFFER_BLOCK_SIZE;
+	block->buffer.length=l;
+	block->handle._private=&block->buffer;
+
+	return &block->handle;
+}
+
+DSPlug_DataBuffer * DSPlug_DataBuffer_create_wrapped( const void *d, int l, void (*f)(const void *, void *), void *u ) {
+
+	DSPlug_DataBufferBlock *block;
+
+	if (l<0 || (l>0 && !d)) {
+
+		DSPlug_report_error("API: DSPlug_DataBuffer_create_wrapped: Invalid data or length");
+		return NULL;
+	}
+
+	block = (DSPlug_DataBufferBlock*)malloc(sizeof(DSPlug_DataBufferBlock));
+	memset(block,0,sizeof(DSPlug_DataBufferBlock));
+
+	block->buffer.refcount=1;
+	block->buffer.data=d;
+	block->buffer.length=l;
+	block->buffer.free_callback=f;
+	block->buffer.free_userdata=u;
+	block->handle._private=&block->buffer;
+
+	return &block->handle;
+}
+
+void DSPlug_DataBuffer_retain( DSPlug_DataBuffer *p_buffer ) {
+
+	DSPlug_DataBufferPrivate *buffer;
+
+	if (!p_buffer || !p_buffer->_private) {
+
+		DSPlug_report_error("API: DSPlug_DataBuffer_retain: Invalid DataBuffer object (NULL)");
+		return;
+	}
+
+	buffer = (DSPlug_DataBufferPrivate*)p_buffer->_private;
+
+	DSPLUG_ATOMIC_FETCH_ADD(&buffer->refcount,1);
+}
+
+void DSPlug_DataBuffer_release( DSPlug_DataBuffer *p_buffer ) {
+
+	DSPlug_DataBufferPrivate *buffer;
+
+	if (!p_buffer || !p_buffer->_private) {
+
+		DSPlug_report_error("API: DSPlug_DataBuffer_release: Invalid DataBuffer object (NULL)");
+		return;
+	}
+
+	buffer = (DSPlug_DataBufferPrivate*)p_buffer->_private;
+
+	if (DSPLUG_ATOMIC_FETCH_ADD(&buffer->refcount,-1)!=1)
+		return;
+
+	if (buffer->free_callback)
+		buffer->free_callback(buffer->data,buffer->free_userdata);
+
+	free(p_buffer); /* the whole block */
+}
+
+const void * DSPlug_DataBuffer_get_data( DSPlug_DataBuffer *p_buffer ) {
+
+	DSPlug_DataBufferPrivate *buffer = (DSPlug_DataBufferPrivate*)p_buffer->_private;
+
+	return buffer->data;
+}
+
+int DSPlug_DataBuffer_get_length( DSPlug_DataBuffer *p_buffer ) {
+
+	DSPlug_DataBufferPrivate *buffer = (DSPlug_DataBufferPrivate*)p_buffer->_private;
+
+	return buffer->length;
+}
@@ -0,0 +1,683 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_event.h"
+#include "dsplug_event_private.h"
+#include "dsplug_atomic.h"
+#include "dsplug_error_report.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/****************************/
+
+/* EVENT QUEUE */
+
+/****************************/
+
+DSPlug_EventQueue * DSPlug_EventQueue_create( int c ) {
+
+	return DSPlug_EventQueue_create_with_payload_arena(c,0);
+}
+
+DSPlug_EventQueue * DSPlug_EventQueue_create_with_payload_arena( int c, int p ) {
+
+	DSPlug_EventQueue *queue_public;
+	DSPlug_EventQueuePrivate *queue;
+	unsigned int capacity=1;
+
+	if (c==0)
+		c=DSPLUG_EVENT_QUEUE_DEFAULT_CAPACITY;
+
+	if (c<0 || c>DSPLUG_EVENT_QUEUE_MAX_CAPACITY) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_create: Invalid queue capacity");
+		return NULL;
+	}
+
+	if (p<0 || p>DSPLUG_EVENT_PAYLOAD_ARENA_MAX_SIZE) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_create: Invalid payload arena size");
+		return NULL;
+	}
+
+	while (capacity<(unsigned int)c)
+		capacity<<=1;
+
+	queue = (DSPlug_EventQueuePrivate*)malloc(sizeof(DSPlug_EventQueuePrivate));
+	memset(queue,0,sizeof(DSPlug_EventQueuePrivate));
+
+	queue->events = (DSPlug_Event*)malloc(sizeof(DSPlug_Event)*capacity);
+	memset(queue->events,0,sizeof(DSPlug_Event)*capacity);
+	queue->capacity=capacity;
+	queue->mask=capacity-1;
+	queue->source=queue;
+
+	if (p) {
+
+		queue->payload_arena = (unsigned char*)malloc(p);
+		memset(queue->payload_arena,0,p);
+		queue->payload_arena_size=p;
+		queue->payload_slots = (unsigned char*)malloc(capacity);
+		memset(queue->payload_slots,0,capacity);
+	}
+
+	queue_public = (DSPlug_EventQueue*)malloc(sizeof(DSPlug_EventQueue));
+	queue_public->_private=queue;
+
+	return queue_public;
+}
+
+void DSPlug_EventQueue_destroy( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue;
+
+	if (!p_queue || !p_queue->_private) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_destroy: Invalid EventQueue object (NULL)");
+		return;
+	}
+
+	queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	if (queue->source!=queue) {
+
+		/* A reader view, unregister it from its source. The producer walks the
+		   readers when pushing, so it must be idle, as when creating the view */
+		DSPlug_EventQueuePrivate *source=queue->source;
+		int i;
+
+		for (i=0;i<source->reader_count;i++) {
+
+			if (source->readers[i]==queue) {
+
+				source->readers[i]=source->readers[source->reader_count-1];
+				source->reader_count--;
+				break;
+			}
+		}
+
+		free(queue);
+		free(p_queue);
+		return;
+	}
+
+	if (queue->reader_count) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_destroy: Queue still has reader views");
+		return;
+	}
+
+	free(queue->events);
+	if (queue->payload_arena) {
+		free(queue->payload_arena);
+		free(queue->payload_slots);
+	}
+	free(queue);
+	free(p_queue);
+}
+
+DSPlug_EventQueue * DSPlug_EventQueue_create_reader( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueue *reader_public;
+	DSPlug_EventQueuePrivate *source;
+	DSPlug_EventQueuePrivate *reader;
+
+	if (!p_queue || !p_queue->_private) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_create_reader: Invalid EventQueue object (NULL)");
+		return NULL;
+	}
+
+	source = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	if (source->source!=source) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_create_reader: Can't create a reader view of a reader view");
+		return NULL;
+	}
+
+	if (source->reader_count>=DSPLUG_EVENT_QUEUE_MAX_READERS) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_create_reader: Maximum number of reader views reached");
+		return NULL;
+	}
+
+	reader = (DSPlug_EventQueuePrivate*)malloc(sizeof(DSPlug_EventQueuePrivate));
+	memset(reader,0,sizeof(DSPlug_EventQueuePrivate));
+
+	reader->events=source->events;
+	reader->capacity=source->capacity;
+	reader->mask=source->mask;
+	reader->payload_arena=source->payload_arena;
+	reader->payload_arena_size=source->payload_arena_size;
+	reader->payload_slots=source->payload_slots;
+	reader->source=source;
+	reader->read_pos=source->write_pos;
+
+	/* the view must be complete before the producer can see it */
+	DSPLUG_MEMORY_BARRIER();
+	source->readers[source->reader_count]=reader;
+	DSPLUG_MEMORY_BARRIER();
+	source->reader_count++;
+
+	reader_public = (DSPlug_EventQueue*)malloc(sizeof(DSPlug_EventQueue));
+	reader_public->_private=reader;
+
+	return reader_public;
+}
+
+int DSPlug_EventQueue_get_capacity( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return (int)queue->capacity;
+}
+
+int DSPlug_EventQueue_get_pending_count( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	unsigned int write_pos = queue->source->write_pos;
+	unsigned int read_pos = queue->read_pos;
+
+	return (int)(write_pos-read_pos);
+}
+
+/* Find the read position of the slowest consumer, the source queue included */
+static unsigned int DSPlug_EventQueue_get_slowest_read_pos( DSPlug_EventQueuePrivate *queue ) {
+
+	unsigned int write_pos = queue->write_pos;
+	unsigned int slowest = queue->read_pos;
+	unsigned int read_pos;
+	int i;
+
+	for (i=0;i<queue->reader_count;i++) {
+
+		read_pos=queue->readers[i]->read_pos;
+		if ((write_pos-read_pos)>(write_pos-slowest))
+			slowest=read_pos;
+	}
+
+	return slowest;
+}
+
+/* Producer side */
+
+void DSPlug_EventQueue_set_overflow_policy( DSPlug_EventQueue *p_queue, DSPlug_EventQueueOverflowPolicy p ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	queue->overflow_policy=p;
+}
+
+/* Check that no consumer, the source queue included, has reached the slot yet */
+static DSPlug_Boolean DSPlug_EventQueue_is_unread( DSPlug_EventQueuePrivate *queue, unsigned int pos ) {
+
+	unsigned int write_pos = queue->write_pos;
+	unsigned int read_pos;
+	int i;
+
+	read_pos=queue->read_pos;
+	if ((pos-read_pos)<1 || (pos-read_pos)>=(write_pos-read_pos))
+		return DSPLUG_FALSE;
+
+	for (i=0;i<queue->reader_count;i++) {
+
+		read_pos=queue->readers[i]->read_pos;
+		if ((pos-read_pos)<1 || (pos-read_pos)>=(write_pos-read_pos))
+			return DSPLUG_FALSE;
+	}
+
+	return DSPLUG_TRUE;
+}
+
+/* Merge a controller change into the newest pending one of the same controller */
+static DSPlug_Boolean DSPlug_EventQueue_coalesce_controller( DSPlug_EventQueuePrivate *queue, const DSPlug_Event *ev ) {
+
+	DSPlug_Event *pending;
+	unsigned int pos;
+	unsigned int oldest;
+
+	if (ev->type!=DSPLUG_MIDI_EVENT_MESSAGE || (ev->data.bytes[0]&DSPLUG_MIDI_STATUS_TYPE_MASK)!=DSPLUG_MIDI_STATUS_CONTROLLER)
+		return DSPLUG_FALSE;
+
+	/* Search only the newest events, so a full queue doesn't cost a scan of it all on every push */
+	oldest=queue->write_pos-queue->slowest_read_pos;
+	oldest=queue->write_pos-(oldest<DSPLUG_EVENT_QUEUE_COALESCE_WINDOW?oldest:DSPLUG_EVENT_QUEUE_COALESCE_WINDOW);
+
+	/* The slot at a read position may be getting copied, so only slots past every consumer are candidates */
+	for (pos=queue->write_pos;pos!=oldest;) {
+
+		pos--;
+
+		if (!DSPlug_EventQueue_is_unread(queue,pos))
+			return DSPLUG_FALSE; /* the older ones are taken too */
+
+		pending=&queue->events[pos&queue->mask];
+
+		if (pending->type==DSPLUG_MIDI_EVENT_MESSAGE && pending->data.bytes[0]==ev->data.bytes[0] && pending->data.bytes[1]==ev->data.bytes[1]) {
+
+			pending->data.bytes[2]=ev->data.bytes[2];
+
+			/* A consumer reaching the slot after this sees the new value, one that got there first may not */
+			DSPLUG_MEMORY_BARRIER();
+			return DSPlug_EventQueue_is_unread(queue,pos);
+		}
+	}
+
+	return DSPLUG_FALSE;
+}
+
+/* Tell the consumer of the queue that it has events */
+static void DSPlug_EventQueue_notify_pending( DSPlug_EventQueuePrivate *queue ) {
+
+	unsigned int bit = queue->pending_bit;
+	volatile unsigned int *word = queue->pending_word; /* the bit is set first when connecting */
+
+	/* the consumer clears the bit before looking at the queue again, so a set bit needs no write */
+	if (word && !(*word&bit))
+		DSPLUG_ATOMIC_FETCH_OR(word,bit);
+}
+
+/* Make room by discarding the oldest event of the slowest consumers */
+static void DSPlug_EventQueue_drop_oldest( DSPlug_EventQueuePrivate *queue ) {
+
+	unsigned int oldest = queue->write_pos-queue->capacity;
+	int i;
+
+	/* The consumers may be popping it at the same time, whoever moves first wins */
+	DSPLUG_ATOMIC_CAS(&queue->read_pos,oldest,oldest+1);
+	for (i=0;i<queue->reader_count;i++)
+		DSPLUG_ATOMIC_CAS(&queue->readers[i]->read_pos,oldest,oldest+1);
+
+	queue->slowest_read_pos=oldest+1;
+}
+
+static DSPlug_Boolean DSPlug_EventQueue_push_internal( DSPlug_EventQueuePrivate *queue, const DSPlug_Event *ev, DSPlug_Boolean p_payload ) {
+
+	unsigned int write_pos = queue->write_pos; /* we own it, no need to sync */
+	unsigned int pending;
+	int i;
+
+	/* Consumers are only polled when the last known slowest one seems to be in the way */
+	if ((write_pos-queue->slowest_read_pos)>=queue->capacity) {
+
+		queue->slowest_read_pos=DSPlug_EventQueue_get_slowest_read_pos(queue);
+
+		if ((write_pos-queue->slowest_read_pos)>=queue->capacity) {
+
+			/* full */
+			switch(queue->overflow_policy) {
+
+				case DSPLUG_EVENT_QUEUE_OVERFLOW_DROP_OLDEST: {
+
+					DSPlug_EventQueue_drop_oldest(queue);
+					queue->dropped_count++;
+				} break;
+				case DSPLUG_EVENT_QUEUE_OVERFLOW_COALESCE_CONTROLLERS: {
+
+					if (DSPlug_EventQueue_coalesce_controller(queue,ev)) {
+
+						queue->coalesced_count++;
+						return DSPLUG_TRUE;
+					}
+
+					/* a consumer may have moved while coalescing, then the event is pushed after all */
+					queue->slowest_read_pos=DSPlug_EventQueue_get_slowest_read_pos(queue);
+					if ((write_pos-queue->slowest_read_pos)>=queue->capacity) {
+
+						queue->dropped_count++;
+						return DSPLUG_FALSE;
+					}
+				} break;
+				default: {
+
+					queue->dropped_count++;
+					return DSPLUG_FALSE;
+				}
+			}
+		}
+	}
+
+	/* read_pos must be seen before the slot is overwritten */
+	DSPLUG_MEMORY_BARRIER();
+
+	queue->events[write_pos&queue->mask]=*ev;
+	if (queue->payload_slots)
+		queue->payload_slots[write_pos&queue->mask]=p_payload ? 1 : 0;
+
+	/* the event must be fully written before the consumer can see it */
+	DSPLUG_MEMORY_BARRIER();
+	queue->write_pos=write_pos+1;
+
+	/* After write_pos, so whoever sees the bit also sees the event. The epoch
+	   lets a consumer unsetting its word wait until it's no longer used here */
+	if (queue->notify_count) {
+
+		queue->notify_epoch++;
+		DSPLUG_MEMORY_BARRIER();
+
+		DSPlug_EventQueue_notify_pending(queue);
+		for (i=0;i<queue->reader_count;i++)
+			DSPlug_EventQueue_notify_pending(queue->readers[i]);
+
+		DSPLUG_MEMORY_BARRIER();
+		queue->notify_epoch++;
+	}
+
+	/* The cached slowest position makes this an overestimate, refresh it before trusting a new maximum */
+	pending=write_pos+1-queue->slowest_read_pos;
+	if (pending>queue->high_water) {
+
+		queue->slowest_read_pos=DSPlug_EventQueue_get_slowest_read_pos(queue);
+		pending=write_pos+1-queue->slowest_read_pos;
+		if (pending>queue->high_water)
+			queue->high_water=pending;
+	}
+
+	return DSPLUG_TRUE;
+}
+
+DSPlug_Boolean DSPlug_EventQueue_push( DSPlug_EventQueue *p_queue, const DSPlug_Event *ev ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	if (queue->source!=queue) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_push: Can't push to a reader view");
+		return DSPLUG_FALSE;
+	}
+
+	return DSPlug_EventQueue_push_internal(queue,ev,DSPLUG_FALSE);
+}
+
+int DSPlug_EventQueue_get_high_water( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return (int)queue->source->high_water;
+}
+
+int DSPlug_EventQueue_get_dropped_count( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return (int)queue->source->dropped_count;
+}
+
+int DSPlug_EventQueue_get_coalesced_count( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return (int)queue->source->coalesced_count;
+}
+
+/* Consumer side */
+
+const DSPlug_Event * DSPlug_EventQueue_peek( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	unsigned int read_pos = queue->read_pos; /* we own it, no need to sync */
+	unsigned int write_pos = queue->source->write_pos;
+
+	if (read_pos==write_pos)
+		return NULL; /* empty */
+
+	/* the event can't be read before write_pos was */
+	DSPLUG_MEMORY_BARRIER();
+
+	return &queue->events[read_pos&queue->mask];
+}
+
+const DSPlug_Event * DSPlug_EventQueue_peek_at( DSPlug_EventQueue *p_queue, int i ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	unsigned int read_pos = queue->read_pos; /* we own it, no need to sync */
+	unsigned int write_pos = queue->source->write_pos;
+
+	if (i<0 || (unsigned int)i>=(write_pos-read_pos))
+		return NULL;
+
+	/* the event can't be read before write_pos was */
+	DSPLUG_MEMORY_BARRIER();
+
+	return &queue->events[(read_pos+i)&queue->mask];
+}
+
+DSPlug_Boolean DSPlug_EventQueue_pop( DSPlug_EventQueue *p_queue, DSPlug_Event *ev ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	const DSPlug_Event *head;
+	unsigned int read_pos;
+
+	if (queue->source->overflow_policy==DSPLUG_EVENT_QUEUE_OVERFLOW_DROP_OLDEST) {
+
+		/* The producer may move read_pos too, retry if the slot was dropped while copying it */
+		do {
+
+			read_pos=queue->read_pos;
+			head=DSPlug_EventQueue_peek(p_queue);
+			if (!head)
+				return DSPLUG_FALSE;
+
+			*ev=*head;
+			DSPLUG_MEMORY_BARRIER();
+
+		} while (!DSPLUG_ATOMIC_CAS(&queue->read_pos,read_pos,read_pos+1));
+
+		return DSPLUG_TRUE;
+	}
+
+	head=DSPlug_EventQueue_peek(p_queue);
+
+	if (!head)
+		return DSPLUG_FALSE;
+
+	*ev=*head;
+
+	/* the slot must be fully read before the producer can reuse it */
+	DSPLUG_MEMORY_BARRIER();
+	queue->read_pos=queue->read_pos+1;
+
+	return DSPLUG_TRUE;
+}
+
+DSPlug_Boolean DSPlug_EventQueue_pop_before( DSPlug_EventQueue *p_queue, int f, DSPlug_Event *ev ) {
+
+	const DSPlug_Event *head = DSPlug_EventQueue_peek(p_queue);
+
+	if (!head || head->frame>=f)
+		return DSPLUG_FALSE;
+
+	return DSPlug_EventQueue_pop(p_queue,ev);
+}
+
+void DSPlug_EventQueue_flush( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	DSPLUG_MEMORY_BARRIER();
+	queue->read_pos=queue->source->write_pos;
+}
+
+/* Payload arena */
+
+DSPlug_Boolean DSPlug_EventQueue_push_payload( DSPlug_EventQueue *p_queue, const DSPlug_Event *ev, const void *payload, int size ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	unsigned int offset = queue->payload_used;
+	unsigned int used;
+	DSPlug_Event aux;
+
+	if (queue->source!=queue) {
+
+		DSPlug_report_error("EVENT: DSPlug_EventQueue_push_payload: Can't push to a reader view");
+		return DSPLUG_FALSE;
+	}
+
+	if (size<0 || (unsigned int)size>queue->payload_arena_size-offset) {
+
+		queue->payload_overflow_count++; /* only the producer writes it */
+		return DSPLUG_FALSE;
+	}
+
+	memcpy(&queue->payload_arena[offset],payload,size);
+
+	aux=*ev;
+	aux.data.integers[0]=(int)offset;
+	aux.data.integers[1]=size;
+
+	/* the push barrier also publishes the payload */
+	if (!DSPlug_EventQueue_push_internal(queue,&aux,DSPLUG_TRUE))
+		return DSPLUG_FALSE; /* arena space is left unused, the event never existed */
+
+	/* keep the next payload aligned, clamping to the arena end */
+	used = offset + ((size + DSPLUG_EVENT_PAYLOAD_ALIGNMENT-1) & ~(DSPLUG_EVENT_PAYLOAD_ALIGNMENT-1));
+	if (used>queue->payload_arena_size)
+		used=queue->payload_arena_size;
+
+	queue->payload_used=used;
+	if (used>queue->payload_high_water)
+		queue->payload_high_water=used;
+
+	return DSPLUG_TRUE;
+}
+
+const void * DSPlug_EventQueue_get_payload( DSPlug_EventQueue *p_queue, const DSPlug_Event *ev, int *size ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	unsigned int offset = (unsigned int)ev->data.integers[0];
+	unsigned int length = (unsigned int)ev->data.integers[1];
+
+	if (offset>queue->payload_arena_size || length>queue->payload_arena_size-offset)
+		return NULL;
+
+	if (size)
+		*size=(int)length;
+
+	return &queue->payload_arena[offset];
+}
+
+void DSPlug_EventQueue_reset_payload_arena( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	queue->payload_used=0;
+}
+
+int DSPlug_EventQueue_get_payload_arena_size( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return (int)queue->payload_arena_size;
+}
+
+int DSPlug_EventQueue_get_payload_high_water( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return (int)queue->payload_high_water;
+}
+
+int DSPlug_EventQueue_get_payload_overflow_count( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return (int)queue->payload_overflow_count;
+}
+
+/* Ring positions */
+
+unsigned int DSPlug_EventQueue_get_read_position( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return queue->read_pos;
+}
+
+unsigned int DSPlug_EventQueue_get_write_position( DSPlug_EventQueue *p_queue ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	return queue->source->write_pos;
+}
+
+const DSPlug_Event * DSPlug_EventQueue_get_at_position( DSPlug_EventQueue *p_queue, unsigned int pos, const void **payload, int *size ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	unsigned int read_pos = queue->read_pos;
+	unsigned int write_pos = queue->source->write_pos;
+	const DSPlug_Event *ev;
+
+	if ((pos-read_pos)>=(write_pos-read_pos))
+		return NULL;
+
+	/* the event can't be read before write_pos was */
+	DSPLUG_MEMORY_BARRIER();
+
+	ev=&queue->events[pos&queue->mask];
+	*payload=NULL;
+	*size=0;
+
+	if (queue->payload_slots && queue->payload_slots[pos&queue->mask])
+		*payload=DSPlug_EventQueue_get_payload(p_queue,ev,size);
+
+	return ev;
+}
+
+/* Consumer notification */
+
+DSPlug_Boolean DSPlug_EventQueue_set_pending_flag( DSPlug_EventQueue *p_queue, volatile unsigned int *w, unsigned int b ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+
+	if (queue->pending_word)
+		return (queue->pending_word==w && queue->pending_bit==b) ? DSPLUG_TRUE : DSPLUG_FALSE;
+
+	DSPLUG_ATOMIC_FETCH_ADD(&queue->source->notify_count,1);
+	queue->pending_bit=b;
+	DSPLUG_MEMORY_BARRIER();
+	queue->pending_word=w;
+	DSPLUG_MEMORY_BARRIER();
+
+	/* events pushed before the producer saw the word would go unnoticed */
+	DSPLUG_ATOMIC_FETCH_OR(w,b);
+
+	return DSPLUG_TRUE;
+}
+
+void DSPlug_EventQueue_clear_pending_flag( DSPlug_EventQueue *p_queue, volatile unsigned int *w, unsigned int b ) {
+
+	DSPlug_EventQueuePrivate *queue = (DSPlug_EventQueuePrivate*)p_queue->_private;
+	unsigned int epoch;
+
+	if (queue->pending_word!=w || queue->pending_bit!=b)
+		return;
+
+	queue->pending_word=NULL;
+	DSPLUG_MEMORY_BARRIER();
+	DSPLUG_ATOMIC_FETCH_ADD(&queue->source->notify_count,-1);
+
+	/* A push that is setting bits may have read the word before, wait until it's done.
+	   Pushes never block, so this is short */
+	epoch=queue->source->notify_epoch;
+	if (epoch&1) {
+
+		while (queue->source->notify_epoch==epoch)
+			DSPLUG_MEMORY_BARRIER();
+	}
+}
@@ -0,0 +1,102 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DSPLUG_EVENT_PRIVATE_H
+#define DSPLUG_EVENT_PRIVATE_H
+
+
+#include "dsplug_types.h"
+#include "dsplug_event.h"
+
+/* Keeps the producer and consumer indices in different cache lines */
+#define DSPLUG_EVENT_QUEUE_CACHE_LINE 64
+
+/**
+ * The ring indices are free running, and wrap around naturally as unsigned
+ * integers. The slot of an index is (index & mask), and the amount of events
+ * in the ring is (write_pos - read_pos). write_pos is only ever written
+ * by the producer, and read_pos only by the consumer.
+ *
+ * Reader views share the ring (and arena) of their source queue and only
+ * own a read_pos. The producer can't overwrite a slot until every reader,
+ * the source included, is past it.
+ */
+typedef struct DSPlug_EventQueuePrivate {
+
+	DSPlug_Event *events; /**< ring storage, capacity events */
+	unsigned int capacity; /**< always a power of two */
+	unsigned int mask;
+	DSPlug_EventQueueOverflowPolicy overflow_policy;
+
+	unsigned char *payload_arena; /**< payload storage, NULL if the queue has no arena */
+	unsigned int payload_arena_size;
+	unsigned char *payload_slots; /**< one per event slot, non zero if the event references a payload. NULL if the queue has no arena */
+
+	struct DSPlug_EventQueuePrivate *source; /**< queue owning the ring, itself unless this is a reader view */
+	struct DSPlug_EventQueuePrivate *readers[DSPLUG_EVENT_QUEUE_MAX_READERS]; /**< reader views of this queue */
+	volatile int reader_count;
+
+	volatile unsigned int * volatile pending_word; /**< bitmask word of the input port consuming this view, NULL if none */
+	unsigned int pending_bit; /**< set in pending_word on every push */
+	volatile int notify_count; /**< views of the source, itself included, with a pending_word */
+	volatile unsigned int notify_epoch; /**< odd while the producer is setting bits, so unsetting a word can wait for it */
+
+	char _pad0[DSPLUG_EVENT_QUEUE_CACHE_LINE];
+	volatile unsigned int write_pos; /**< owned by the producer */
+	unsigned int slowest_read_pos; /**< last known position of the slowest reader, owned by the producer */
+	unsigned int payload_used; /**< bump pointer of the arena, owned by the producer */
+	volatile unsigned int payload_high_water;
+	volatile unsigned int payload_overflow_count;
+	volatile unsigned int high_water;
+	volatile unsigned int dropped_count;
+	volatile unsigned int coalesced_count;
+
+	char _pad1[DSPLUG_EVENT_QUEUE_CACHE_LINE];
+	volatile unsigned int read_pos; /**< owned by the consumer */
+
+} DSPlug_EventQueuePrivate;
+
+/**
+ * Make pushes to the queue (or reader view) set a bit in a word, so the
+ * consumer can tell which of its queues have events without looking at them.
+ * A queue can only notify a single consumer.
+ * \return false if the queue already notifies somebody else
+ */
+DSPlug_Boolean DSPlug_EventQueue_set_pending_flag( DSPlug_EventQueue *q, volatile unsigned int *w, unsigned int b );
+
+/**
+ * Stop notifying, only if the queue notifies to the word and bit given.
+ * Waits until the producer is done with the word, so it can be freed afterwards.
+ */
+void DSPlug_EventQueue_clear_pending_flag( DSPlug_EventQueue *q, volatile unsigned int *w, unsigned int b );
+
+/**
+ * Ring positions, for going through the pending events without popping them.
+ * \return read position of the queue (or view) and write position of its source
+ */
+unsigned int DSPlug_EventQueue_get_read_position( DSPlug_EventQueue *q );
+unsigned int DSPlug_EventQueue_get_write_position( DSPlug_EventQueue *q );
+
+/**
+ * \param pos ring position, between the read and write positions
+ * \param payload set to the payload of the event, NULL if it has none
+ * \param size set to the size of the payload
+ * \return event at the position, NULL if the position is not pending
+ */
+const DSPlug_Event * DSPlug_EventQueue_get_at_position( DSPlug_EventQueue *q, unsigned int pos, const void **payload, int *size );
+
+
+#endif /* dsplug_event_private.h */
@@ -0,0 +1,390 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_host.h"
+#include "dsplug_private.h"
+#include "dsplug_error_report.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#define DSPLUG_EVENT_RECORD_MAGIC "DSPLUGEV"
+#define DSPLUG_EVENT_RECORD_VERSION 2
+#define DSPLUG_EVENT_RECORD_CYCLE_MARKER -1 /* port of the record beginning a cycle */
+#define DSPLUG_EVENT_RECORD_MAX_CYCLE_FRAMES (1<<20) /* a longer cycle can only come from a broken file */
+#define DSPLUG_EVENT_RECORD_PAYLOAD_RECORDS(m_size) (((m_size)+sizeof(DSPlug_EventRecord)-1)/sizeof(DSPlug_EventRecord))
+
+/**
+ * File header, followed by the records
+ */
+typedef struct {
+
+	char magic[8];
+	unsigned int version;
+	unsigned int record_size; /**< sizeof(DSPlug_EventRecord) of the machine that wrote it */
+
+} DSPlug_EventRecordHeader;
+
+/**
+ * Every record is either a cycle marker (port is DSPLUG_EVENT_RECORD_CYCLE_MARKER,
+ * event.frame is the amount of frames of the cycle) or an event of the last cycle.
+ * The payload of an event follows its record, padded to a whole amount of records.
+ */
+typedef struct {
+
+	unsigned int cycle;
+	int port;
+	int payload_size; /**< bytes of payload following the record, 0 for none */
+	DSPlug_Event event;
+
+} DSPlug_EventRecord;
+
+typedef struct {
+
+	FILE *file;
+	unsigned int cycle_count;
+
+} DSPlug_EventRecorderPrivate;
+
+typedef struct {
+
+	void *map; /**< the whole mapped file */
+	size_t map_size;
+
+	const DSPlug_EventRecord *records; /**< right after the header */
+	int record_count;
+	int cycle_count;
+
+	int position; /**< next record to replay */
+
+} DSPlug_EventPlayerPrivate;
+
+
+/****************************/
+
+/* EVENT RECORDER */
+
+/****************************/
+
+DSPlug_EventRecorder * DSPlug_EventRecorder_create( const char *p_path ) {
+
+	DSPlug_EventRecorder *recorder_public;
+	DSPlug_EventRecorderPrivate *recorder;
+	DSPlug_EventRecordHeader header;
+	FILE *f;
+
+	f=fopen(p_path,"wb");
+
+	if (!f) {
+
+		DSPlug_report_error("HOST: DSPlug_EventRecorder_create: Can't open file for writing");
+		return NULL;
+	}
+
+	memset(&header,0,sizeof(DSPlug_EventRecordHeader));
+	memcpy(header.magic,DSPLUG_EVENT_RECORD_MAGIC,8);
+	header.version=DSPLUG_EVENT_RECORD_VERSION;
+	header.record_size=sizeof(DSPlug_EventRecord);
+	fwrite(&header,sizeof(DSPlug_EventRecordHeader),1,f);
+
+	recorder = (DSPlug_EventRecorderPrivate*)malloc(sizeof(DSPlug_EventRecorderPrivate));
+	recorder->file=f;
+	recorder->cycle_count=0;
+
+	recorder_public = (DSPlug_EventRecorder*)malloc(sizeof(DSPlug_EventRecorder));
+	recorder_public->_private=recorder;
+
+	return recorder_public;
+}
+
+void DSPlug_EventRecorder_destroy( DSPlug_EventRecorder *p_recorder ) {
+
+	DSPlug_EventRecorderPrivate *recorder;
+
+	if (!p_recorder || !p_recorder->_private) {
+
+		DSPlug_report_error("HOST: DSPlug_EventRecorder_destroy: Invalid EventRecorder object (NULL)");
+		return;
+	}
+
+	recorder = (DSPlug_EventRecorderPrivate*)p_recorder->_private;
+
+	fclose(recorder->file);
+	free(recorder);
+	free(p_recorder);
+}
+
+void DSPlug_EventRecorder_begin_cycle( DSPlug_EventRecorder *p_recorder, int f ) {
+
+	DSPlug_EventRecorderPrivate *recorder = (DSPlug_EventRecorderPrivate*)p_recorder->_private;
+	DSPlug_EventRecord record;
+
+	memset(&record,0,sizeof(DSPlug_EventRecord));
+	record.cycle=recorder->cycle_count;
+	record.port=DSPLUG_EVENT_RECORD_CYCLE_MARKER;
+	record.event.frame=f;
+
+	fwrite(&record,sizeof(DSPlug_EventRecord),1,recorder->file);
+	recorder->cycle_count++;
+}
+
+void DSPlug_EventRecorder_record_event( DSPlug_EventRecorder *p_recorder, int p, const DSPlug_Event *ev ) {
+
+	DSPlug_EventRecorder_record_payload_event(p_recorder,p,ev,NULL,0);
+}
+
+void DSPlug_EventRecorder_record_payload_event( DSPlug_EventRecorder *p_recorder, int p, const DSPlug_Event *ev, const void *payload, int size ) {
+
+	DSPlug_EventRecorderPrivate *recorder = (DSPlug_EventRecorderPrivate*)p_recorder->_private;
+	DSPlug_EventRecord record;
+	size_t padding;
+
+	if (recorder->cycle_count==0) {
+
+		DSPlug_report_error("HOST: DSPlug_EventRecorder_record_event: No cycle begun");
+		return;
+	}
+
+	if (p<0) {
+
+		DSPlug_report_error("HOST: DSPlug_EventRecorder_record_event: Invalid Event Port Index");
+		return;
+	}
+
+	if (size<0 || (size>0 && !payload)) {
+
+		DSPlug_report_error("HOST: DSPlug_EventRecorder_record_event: Invalid Payload");
+		return;
+	}
+
+	memset(&record,0,sizeof(DSPlug_EventRecord));
+	record.cycle=recorder->cycle_count-1;
+	record.port=p;
+	record.payload_size=size;
+	record.event=*ev;
+
+	fwrite(&record,sizeof(DSPlug_EventRecord),1,recorder->file);
+
+	if (size==0)
+		return;
+
+	fwrite(payload,size,1,recorder->file);
+
+	/* zeroed record as padding, so the next record stays aligned */
+	memset(&record,0,sizeof(DSPlug_EventRecord));
+	padding=DSPLUG_EVENT_RECORD_PAYLOAD_RECORDS(size)*sizeof(DSPlug_EventRecord)-size;
+	if (padding)
+		fwrite(&record,padding,1,recorder->file);
+}
+
+int DSPlug_EventRecorder_get_cycle_count( DSPlug_EventRecorder *p_recorder ) {
+
+	DSPlug_EventRecorderPrivate *recorder = (DSPlug_EventRecorderPrivate*)p_recorder->_private;
+
+	return (int)recorder->cycle_count;
+}
+
+
+/****************************/
+
+/* EVENT PLAYER */
+
+/****************************/
+
+DSPlug_EventPlayer * DSPlug_EventPlayer_open( const char *p_path ) {
+
+	DSPlug_EventPlayer *player_public;
+	DSPlug_EventPlayerPrivate *player;
+	const DSPlug_EventRecordHeader *header;
+	struct stat st;
+	void *map;
+	int fd,i,cycles=0;
+	size_t records;
+
+	fd=open(p_path,O_RDONLY);
+
+	if (fd<0) {
+
+		DSPlug_report_error("HOST: DSPlug_EventPlayer_open: Can't open file");
+		return NULL;
+	}
+
+	if (fstat(fd,&st)<0 || st.st_size<(off_t)sizeof(DSPlug_EventRecordHeader)) {
+
+		close(fd);
+		DSPlug_report_error("HOST: DSPlug_EventPlayer_open: Invalid event record file");
+		return NULL;
+	}
+
+	map=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd); /* the mapping keeps the file */
+
+	if (map==MAP_FAILED) {
+
+		DSPlug_report_error("HOST: DSPlug_EventPlayer_open: Can't map file");
+		return NULL;
+	}
+
+	header=(const DSPlug_EventRecordHeader*)map;
+	records=(st.st_size-sizeof(DSPlug_EventRecordHeader))/sizeof(DSPlug_EventRecord);
+
+	if (memcmp(header->magic,DSPLUG_EVENT_RECORD_MAGIC,8)!=0 || header->version!=DSPLUG_EVENT_RECORD_VERSION || header->record_size!=sizeof(DSPlug_EventRecord)) {
+
+		munmap(map,st.st_size);
+		DSPlug_report_error("HOST: DSPlug_EventPlayer_open: Invalid event record file, or recorded in a different kind of machine");
+		return NULL;
+	}
+
+	player = (DSPlug_EventPlayerPrivate*)malloc(sizeof(DSPlug_EventPlayerPrivate));
+	player->map=map;
+	player->map_size=st.st_size;
+	player->records=(const DSPlug_EventRecord*)((const char*)map+sizeof(DSPlug_EventRecordHeader));
+	player->record_count=(int)records;
+	player->position=0;
+
+	for (i=0;i<player->record_count;i+=1+DSPLUG_EVENT_RECORD_PAYLOAD_RECORDS(player->records[i].payload_size)) {
+
+		if (player->records[i].payload_size<0 || (size_t)player->records[i].payload_size>(size_t)(player->record_count-i-1)*sizeof(DSPlug_EventRecord)) {
+
+			munmap(map,st.st_size);
+			free(player);
+			DSPlug_report_error("HOST: DSPlug_EventPlayer_open: Invalid event record file, truncated payload");
+			return NULL;
+		}
+
+		/* ports above the ones of the instance are skipped when playing, as they depend on it */
+		if (player->records[i].port<DSPLUG_EVENT_RECORD_CYCLE_MARKER) {
+
+			munmap(map,st.st_size);
+			free(player);
+			DSPlug_report_error("HOST: DSPlug_EventPlayer_open: Invalid event record file, bad port");
+			return NULL;
+		}
+
+		if (player->records[i].port==DSPLUG_EVENT_RECORD_CYCLE_MARKER) {
+
+			if (player->records[i].event.frame<0 || player->records[i].event.frame>DSPLUG_EVENT_RECORD_MAX_CYCLE_FRAMES) {
+
+				munmap(map,st.st_size);
+				free(player);
+				DSPlug_report_error("HOST: DSPlug_EventPlayer_open: Invalid event record file, bad cycle length");
+				return NULL;
+			}
+
+			cycles++;
+		}
+	}
+
+	player->cycle_count=cycles;
+
+	player_public = (DSPlug_EventPlayer*)malloc(sizeof(DSPlug_EventPlayer));
+	player_public->_private=player;
+
+	return player_public;
+}
+
+void DSPlug_EventPlayer_close( DSPlug_EventPlayer *p_player ) {
+
+	DSPlug_EventPlayerPrivate *player;
+
+	if (!p_player || !p_player->_private) {
+
+		DSPlug_report_error("HOST: DSPlug_EventPlayer_close: Invalid EventPlayer object (NULL)");
+		return;
+	}
+
+	player = (DSPlug_EventPlayerPrivate*)p_player->_private;
+
+	munmap(player->map,player->map_size);
+	free(player);
+	free(p_player);
+}
+
+int DSPlug_EventPlayer_get_cycle_count( DSPlug_EventPlayer *p_player ) {
+
+	DSPlug_EventPlayerPrivate *player = (DSPlug_EventPlayerPrivate*)p_player->_private;
+
+	return player->cycle_count;
+}
+
+void DSPlug_EventPlayer_rewind( DSPlug_EventPlayer *p_player ) {
+
+	DSPlug_EventPlayerPrivate *player = (DSPlug_EventPlayerPrivate*)p_player->_private;
+
+	player->position=0;
+}
+
+DSPlug_Boolean DSPlug_EventPlayer_process_cycle( DSPlug_EventPlayer *p_player, DSPlug_PluginInstance *p_instance ) {
+
+	DSPlug_EventPlayerPrivate *player = (DSPlug_EventPlayerPrivate*)p_player->_private;
+	DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	const DSPlug_EventRecord *record;
+	DSPlug_EventQueue *queue;
+	int frames,i;
+
+	if (plugin_public==NULL || plugin==NULL) {
+
+		DSPlug_report_error("HOST: DSPlug_EventPlayer_process_cycle: Calling with NULL PluginInstance ");
+		return DSPLUG_FALSE;
+	}
+
+	/* Skip anything before the first cycle, it can only come from a broken file */
+	while (player->position<player->record_count && player->records[player->position].port!=DSPLUG_EVENT_RECORD_CYCLE_MARKER)
+		player->position+=1+DSPLUG_EVENT_RECORD_PAYLOAD_RECORDS(player->records[player->position].payload_size);
+
+	if (player->position>=player->record_count)
+		return DSPLUG_FALSE;
+
+	frames=player->records[player->position].event.frame;
+	player->position++;
+
+	/* The player is the producer, payloads of previous cycles go away once their events were consumed */
+	for (i=0;i<plugin->event_port_count;i++) {
+
+		queue=plugin->event_ports[i].queue;
+		if (queue && queue!=plugin->event_ports[i].generated_queue && DSPlug_EventQueue_get_payload_arena_size(queue) && DSPlug_EventQueue_get_pending_count(queue)==0)
+			DSPlug_EventQueue_reset_payload_arena(queue);
+	}
+
+	for (;player->position<player->record_count;player->position+=1+DSPLUG_EVENT_RECORD_PAYLOAD_RECORDS(record->payload_size)) {
+
+		record=&player->records[player->position];
+
+		if (record->port==DSPLUG_EVENT_RECORD_CYCLE_MARKER)
+			break;
+
+		if (record->port>=plugin->event_port_count || !plugin->event_ports[record->port].queue)
+			continue;
+
+		queue=plugin->event_ports[record->port].queue;
+
+		if (record->payload_size)
+			DSPlug_EventQueue_push_payload(queue,&record->event,record+1,record->payload_size);
+		else
+			DSPlug_EventQueue_push(queue,&record->event);
+	}
+
+	DSPlug_PluginInstance_process(p_instance,frames);
+
+	return DSPLUG_TRUE;
+}
@@ -15,6 +15,7 @@
  ***************************************************************************/
 
 #include "dsplug_helpers.h"
+#include "dsplug_atomic.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -30,28 +31,29 @@ void DSPlug_validate_path_to_newstring(char** p_dst,const char *p_src) {
 
 
 	char * auxbuf;
+	int len;
 
 	if (!p_src)
 		return;
 
-	if (strlen(p_src)==0) { /* if none, set "/" */
+	if (strlen(p_src)==0 || (strlen(p_src)==1 && p_src[0]=='/')) { /* if none, set "/" */
 
 		DSPlug_copy_to_newstring(p_dst,"/");
 		return;
-	} else if (strlen(p_src)==1 && p_src[0]=='/') {
-		/* nothing to do */
-		return;
 	}
 
-	auxbuf=(char*)malloc( strlen(p_src) + 3 ); /* +pre+post+null */
+	auxbuf=(char*)malloc( strlen(p_src) + 2 ); /* +pre+null */
 
 	if (p_src[0]!='/') {
 		strcpy(&auxbuf[1],p_src);
 		auxbuf[0]='/';
+	} else {
+		strcpy(auxbuf,p_src);
 	}
 
-	if (p_src[ strlen(p_src) - 1 ]!='/')
-		auxbuf[ strlen(auxbuf) - 2 ] = 0; /* make last char '/' dissapear */
+	len=strlen(auxbuf);
+	if (len>1 && auxbuf[len-1]=='/')
+		auxbuf[len-1] = 0; /* make last char '/' dissapear */
 
 	DSPlug_copy_to_newstring(p_dst,auxbuf);
 
@@ -74,6 +76,278 @@ DSPlug_Boolean DSPlug_check_features_bit(DSPlug_PluginCapsPrivate *p_caps,DSPlug
 
 }
 
+/* Port Index */
+
+#define DSPLUG_HASH_SEED 2166136261U
+
+/* FNV-1a, continuing from h */
+static unsigned int DSPlug_hash_string(unsigned int h,const char *s) {
+
+	while (*s) {
+
+		h^=(unsigned char)*s++;
+		h*=16777619U;
+	}
+
+	return h;
+}
+
+/* hash of the full port path, as in "/filter/cutoff", without building the string */
+static unsigned int DSPlug_hash_port_path(const char *p_path,const char *p_name) {
+
+	unsigned int h=DSPlug_hash_string(DSPLUG_HASH_SEED,p_path);
+
+	if (p_path[0]==0 || p_path[strlen(p_path)-1]!='/')
+		h=DSPlug_hash_string(h,"/");
+
+	return DSPlug_hash_string(h,p_name);
+}
+
+static DSPlug_Boolean DSPlug_match_port_path(const char *p_key,const char *p_path,const char *p_name) {
+
+	int len=strlen(p_path);
+
+	if (strncmp(p_key,p_path,len)!=0)
+		return DSPLUG_FALSE;
+
+	p_key+=len;
+
+	if (len==0 || p_path[len-1]!='/') {
+
+		if (*p_key!='/')
+			return DSPLUG_FALSE;
+		p_key++;
+	}
+
+	return strcmp(p_key,p_name)==0 ? DSPLUG_TRUE : DSPLUG_FALSE;
+}
+
+static void DSPlug_insert_port_index_slot(DSPlug_PortIndexSlot *p_slots,unsigned int p_mask,DSPlug_CommonPortCapsPrivate **p_ports,int p_port,DSPlug_Boolean p_by_path) {
+
+	DSPlug_CommonPortCapsPrivate *port=p_ports[p_port];
+	unsigned int h = p_by_path ? DSPlug_hash_port_path(port->path,port->name) : DSPlug_hash_string(DSPLUG_HASH_SEED,port->name);
+	unsigned int pos=h&p_mask;
+	DSPlug_CommonPortCapsPrivate *other;
+
+	while (p_slots[pos].port>=0) {
+
+		other=p_ports[p_slots[pos].port];
+
+		if (p_slots[pos].hash==h && !strcmp(other->name,port->name) && (!p_by_path || !strcmp(other->path,port->path)))
+			return; /* repeated, the first port keeps the key */
+
+		pos=(pos+1)&p_mask;
+	}
+
+	p_slots[pos].hash=h;
+	p_slots[pos].port=p_port;
+}
+
+void DSPlug_build_port_index(DSPlug_PortIndexPrivate *p_index,DSPlug_CommonPortCapsPrivate **p_ports,int p_count) {
+
+	unsigned int size=8;
+	unsigned int i;
+
+	DSPlug_free_port_index(p_index);
+
+	if (p_count<=0)
+		return;
+
+	while (size<(unsigned int)p_count*2) /* keep the load under one half */
+		size<<=1;
+
+	p_index->mask=size-1;
+	p_index->name_slots=(DSPlug_PortIndexSlot*)malloc(sizeof(DSPlug_PortIndexSlot)*size);
+	p_index->path_slots=(DSPlug_PortIndexSlot*)malloc(sizeof(DSPlug_PortIndexSlot)*size);
+
+	for (i=0;i<size;i++) {
+
+		p_index->name_slots[i].port=-1;
+		p_index->path_slots[i].port=-1;
+	}
+
+	for (i=0;i<(unsigned int)p_count;i++) {
+
+		DSPlug_insert_port_index_slot(p_index->name_slots,p_index->mask,p_ports,i,DSPLUG_FALSE);
+		DSPlug_insert_port_index_slot(p_index->path_slots,p_index->mask,p_ports,i,DSPLUG_TRUE);
+	}
+}
+
+int DSPlug_find_port_index(const DSPlug_PortIndexPrivate *p_index,DSPlug_CommonPortCapsPrivate **p_ports,const char *p_key) {
+
+	DSPlug_Boolean by_path = (p_key[0]=='/') ? DSPLUG_TRUE : DSPLUG_FALSE;
+	const DSPlug_PortIndexSlot *slots = by_path ? p_index->path_slots : p_index->name_slots;
+	unsigned int h = DSPlug_hash_string(DSPLUG_HASH_SEED,p_key);
+	unsigned int pos=h&p_index->mask;
+	DSPlug_CommonPortCapsPrivate *port;
+
+	if (!slots)
+		return -1;
+
+	while (slots[pos].port>=0) {
+
+		port=p_ports[slots[pos].port];
+
+		if (slots[pos].hash==h) {
+
+			if (by_path ? DSPlug_match_port_path(p_key,port->path,port->name) : !strcmp(p_key,port->name))
+				return slots[pos].port;
+		}
+
+		pos=(pos+1)&p_index->mask;
+	}
+
+	return -1;
+}
+
+void DSPlug_free_port_index(DSPlug_PortIndexPrivate *p_index) {
+
+	free(p_index->name_slots);
+	free(p_index->path_slots);
+	p_index->name_slots=NULL;
+	p_index->path_slots=NULL;
+	p_index->mask=0;
+}
+
+/* Musical Part Index */
+
+void DSPlug_build_musical_part_index(DSPlug_PluginCapsPrivate *p_caps) {
+
+	int i,part;
+
+	free(p_caps->musical_part_offsets);
+	free(p_caps->musical_part_ports);
+	p_caps->musical_part_count=0;
+
+	for (i=0;i<p_caps->control_port_count;i++) {
+
+		if (p_caps->control_port_caps[i]->musical_part>p_caps->musical_part_count)
+			p_caps->musical_part_count=p_caps->control_port_caps[i]->musical_part; /* stored plus one */
+	}
+
+	p_caps->musical_part_offsets=(int*)malloc(sizeof(int)*(p_caps->musical_part_count+1));
+	p_caps->musical_part_ports=(int*)malloc(sizeof(int)*(p_caps->control_port_count+1));
+	memset(p_caps->musical_part_offsets,0,sizeof(int)*(p_caps->musical_part_count+1));
+
+	/* count the ports of every part, then turn the counts into offsets */
+	for (i=0;i<p_caps->control_port_count;i++) {
+
+		part=p_caps->control_port_caps[i]->musical_part-1;
+		if (part>=0)
+			p_caps->musical_part_offsets[part+1]++;
+	}
+
+	for (i=0;i<p_caps->musical_part_count;i++)
+		p_caps->musical_part_offsets[i+1]+=p_caps->musical_part_offsets[i];
+
+	/* offsets[N] is now the beginning of part N, use it as the cursor to fill it */
+	for (i=0;i<p_caps->control_port_count;i++) {
+
+		part=p_caps->control_port_caps[i]->musical_part-1;
+		if (part>=0)
+			p_caps->musical_part_ports[p_caps->musical_part_offsets[part]++]=i;
+	}
+
+	/* every cursor ended at the beginning of the next part, shift them back */
+	for (i=p_caps->musical_part_count;i>0;i--)
+		p_caps->musical_part_offsets[i]=p_caps->musical_part_offsets[i-1];
+	p_caps->musical_part_offsets[0]=0;
+}
+
+/* String Options */
+
+static void DSPlug_build_string_option_slots(DSPlug_ControlPortCapsPrivate *p_caps) {
+
+	unsigned int size=8;
+	unsigned int i,pos;
+
+	while (size<(unsigned int)p_caps->string_option_count*2) /* keep the load under one half */
+		size<<=1;
+
+	free(p_caps->string_option_slots);
+	p_caps->string_option_mask=size-1;
+	p_caps->string_option_slots=(int*)malloc(sizeof(int)*size);
+
+	for (i=0;i<size;i++)
+		p_caps->string_option_slots[i]=-1;
+
+	for (i=0;i<(unsigned int)p_caps->string_option_count;i++) {
+
+		pos=p_caps->string_option_hashes[i]&p_caps->string_option_mask;
+
+		while (p_caps->string_option_slots[pos]>=0)
+			pos=(pos+1)&p_caps->string_option_mask;
+
+		p_caps->string_option_slots[pos]=i;
+	}
+}
+
+int DSPlug_add_string_option(DSPlug_ControlPortCapsPrivate *p_caps,const char *p_string) {
+
+	int i=DSPlug_find_string_option(p_caps,p_string);
+
+	if (i>=0)
+		return i;
+
+	i=p_caps->string_option_count++;
+	p_caps->string_options=(char**)realloc(p_caps->string_options,sizeof(char*)*p_caps->string_option_count);
+	p_caps->string_option_hashes=(unsigned int*)realloc(p_caps->string_option_hashes,sizeof(unsigned int)*p_caps->string_option_count);
+	p_caps->string_options[i]=NULL;
+	DSPlug_copy_to_newstring(&p_caps->string_options[i],p_string);
+	p_caps->string_option_hashes[i]=DSPlug_hash_string(DSPLUG_HASH_SEED,p_string);
+
+	DSPlug_build_string_option_slots(p_caps);
+
+	return i;
+}
+
+int DSPlug_find_string_option(const DSPlug_ControlPortCapsPrivate *p_caps,const char *p_string) {
+
+	unsigned int h,pos;
+
+	if (!p_caps->string_option_slots)
+		return -1;
+
+	h=DSPlug_hash_string(DSPLUG_HASH_SEED,p_string);
+	pos=h&p_caps->string_option_mask;
+
+	while (p_caps->string_option_slots[pos]>=0) {
+
+		if (p_caps->string_option_hashes[p_caps->string_option_slots[pos]]==h && !strcmp(p_caps->string_options[p_caps->string_option_slots[pos]],p_string))
+			return p_caps->string_option_slots[pos];
+
+		pos=(pos+1)&p_caps->string_option_mask;
+	}
+
+	return -1;
+}
+
+/* Change Tracking */
+
+void DSPlug_mark_control_port_changed(DSPlug_PluginPrivate *p_plugin,int p_port) {
+
+	unsigned int g=DSPLUG_ATOMIC_FETCH_ADD(&p_plugin->change_generation,1)+1;
+	unsigned int old;
+	DSPlug_ChangeLogEntry *entry;
+
+	if (g==0) /* zero means never changed, skip it when wrapping around */
+		g=DSPLUG_ATOMIC_FETCH_ADD(&p_plugin->change_generation,1)+1;
+
+	/* Another thread may be marking the port too, the newest generation must stay */
+	do {
+
+		old=p_plugin->port_generations[p_port];
+		if (old!=0 && (int)(g-old)<=0)
+			break;
+
+	} while (!DSPLUG_ATOMIC_CAS(&p_plugin->port_generations[p_port],old,g));
+
+	entry=&p_plugin->change_log[g&p_plugin->change_log_mask];
+	entry->port=p_port;
+	DSPLUG_MEMORY_BARRIER();
+	entry->generation=g;
+}
+
 void DSPlug_free_common_port_caps(DSPlug_CommonPortCapsPrivate *p_port_caps) {
 
 	free(p_port_caps->name);
@@ -85,7 +359,7 @@ void DSPlug_free_common_port_caps(DSPlug_CommonPortCapsPrivate *p_port_caps) {
 
 void DSPlug_free_plugin_caps(DSPlug_PluginCapsPrivate *p_plugin_caps) {
 
-        int i;
+        int i,j;
 
 	free(p_plugin_caps->info_caption);
 	free(p_plugin_caps->info_author);
@@ -114,10 +388,22 @@ void DSPlug_free_plugin_caps(DSPlug_PluginCapsPrivate *p_plugin_caps) {
 	for (i=0;i<p_plugin_caps->control_port_count;i++) {
 
 		DSPlug_free_common_port_caps(&p_plugin_caps->control_port_caps[i]->common);
+
+		for (j=0;j<p_plugin_caps->control_port_caps[i]->string_option_count;j++)
+			free(p_plugin_caps->control_port_caps[i]->string_options[j]);
+		free(p_plugin_caps->control_port_caps[i]->string_options);
+		free(p_plugin_caps->control_port_caps[i]->string_option_hashes);
+		free(p_plugin_caps->control_port_caps[i]->string_option_slots);
+
 		free(p_plugin_caps->control_port_caps[i]);
 	}
 	free(p_plugin_caps->control_port_caps);
 
+	for (i=0;i<3;i++)
+		DSPlug_free_port_index(&p_plugin_caps->port_index[i]);
+
+	free(p_plugin_caps->musical_part_offsets);
+	free(p_plugin_caps->musical_part_ports);
 
 	free(p_plugin_caps);
 }
@@ -25,5 +25,12 @@ void DSPlug_validate_path_to_newstring(char** p_dst,const char *p_src);
 void DSPlug_free_common_port_caps(DSPlug_CommonPortCapsPrivate *);
 void DSPlug_free_plugin_caps(DSPlug_PluginCapsPrivate *);
 DSPlug_Boolean DSPlug_check_features_bit(DSPlug_PluginCapsPrivate *,DSPlug_PluginFeature f);
+void DSPlug_build_port_index(DSPlug_PortIndexPrivate *,DSPlug_CommonPortCapsPrivate **p_ports,int p_count);
+int DSPlug_find_port_index(const DSPlug_PortIndexPrivate *,DSPlug_CommonPortCapsPrivate **p_ports,const char *p_key);
+void DSPlug_free_port_index(DSPlug_PortIndexPrivate *);
+void DSPlug_build_musical_part_index(DSPlug_PluginCapsPrivate *);
+int DSPlug_add_string_option(DSPlug_ControlPortCapsPrivate *,const char *p_string);
+int DSPlug_find_string_option(const DSPlug_ControlPortCapsPrivate *,const char *p_string);
+void DSPlug_mark_control_port_changed(DSPlug_PluginPrivate *,int p_port);
 
 #endif
@@ -29,6 +29,9 @@
 #include "dsplug_error_report.h"
 #include "dsplug_library.h"
 #include "dsplug_helpers.h"
+#include "dsplug_atomic.h"
+#include "dsplug_smoother.h"
+#include "dsplug_event_private.h"
 
 
 /****************************/
@@ -145,6 +148,121 @@ DSPlug_PluginCaps DSPlug_PluginLibrary_get_plugin_caps( DSPlug_PluginLibrary * p
  * This is one of the most complex functions in the api, as it is in charge of the plugin instance initialization
  */
 
+/* Everything an instance needs is laid out in a single block. The layout
+   runs twice, first without a block to measure it, then placing the parts */
+
+#define DSPLUG_INSTANCE_ARENA_ALIGNMENT 16
+
+typedef struct {
+
+	char *base; /* NULL while measuring */
+	size_t size;
+
+} DSPlug_InstanceArena;
+
+static void * DSPlug_InstanceArena_take( DSPlug_InstanceArena *p_arena, size_t p_size ) {
+
+	void *part = p_arena->base ? p_arena->base+p_arena->size : NULL;
+
+	p_arena->size+=(p_size+DSPLUG_INSTANCE_ARENA_ALIGNMENT-1)&~(size_t)(DSPLUG_INSTANCE_ARENA_ALIGNMENT-1);
+
+	return part;
+}
+
+static DSPlug_PluginInstance * DSPlug_PluginInstance_layout( DSPlug_InstanceArena *p_arena, DSPlug_PluginCapsPrivate *caps, int p_smoothed, int p_async, int p_managed ) {
+
+	DSPlug_PluginInstance *plugin_instance;
+	DSPlug_Plugin *plugin;
+	DSPlug_PluginPrivate *plugin_private;
+	float **channels;
+	int cp=caps->control_port_count;
+	int i,channel_count=0,string_size=0,log_size,words;
+
+	for (i=0;i<caps->audio_port_count;i++)
+		channel_count+=caps->audio_port_caps[i]->channel_count;
+
+	for (i=0;i<cp;i++) {
+
+		if (caps->control_port_caps[i]->managed_string)
+			string_size+=(caps->control_port_caps[i]->realtime_port_string_max_len+1)*3;
+	}
+
+	log_size=DSPLUG_CHANGE_LOG_MIN_SIZE;
+	while (log_size<cp*4)
+		log_size<<=1;
+
+	words=(cp+31)/32;
+
+	plugin_instance=(DSPlug_PluginInstance*)DSPlug_InstanceArena_take(p_arena,sizeof(DSPlug_PluginInstance));
+	plugin=(DSPlug_Plugin*)DSPlug_InstanceArena_take(p_arena,sizeof(DSPlug_Plugin));
+	plugin_private=(DSPlug_PluginPrivate*)DSPlug_InstanceArena_take(p_arena,sizeof(DSPlug_PluginPrivate));
+
+	if (p_arena->base) {
+
+		memset(plugin_private,0,sizeof(DSPlug_PluginPrivate));
+		plugin_instance->_private=plugin;
+		plugin->_private=plugin_private;
+		plugin_private->plugin_caps=caps;
+		plugin_private->audio_port_count=caps->audio_port_count;
+		plugin_private->event_port_count=caps->event_port_count;
+		plugin_private->control_port_count=cp;
+		plugin_private->change_log_mask=log_size-1;
+		plugin_private->UI_summary_words=(words+31)/32;
+	} else {
+
+		plugin_private=NULL; /* nothing is placed while measuring */
+	}
+
+	/* ports, hot data first, so processing touches few cache lines */
+#define DSPLUG_ARENA_ARRAY(m_field,m_type,m_count) \
+	{ m_type *array=(m_type*)DSPlug_InstanceArena_take(p_arena,sizeof(m_type)*(m_count)); if (plugin_private) plugin_private->m_field=array; }
+
+	DSPLUG_ARENA_ARRAY(audio_ports,DSPlug_AudioPortPrivate,caps->audio_port_count);
+	channels=(float**)DSPlug_InstanceArena_take(p_arena,sizeof(float*)*(channel_count+1));
+	DSPLUG_ARENA_ARRAY(event_ports,DSPlug_EventPortPrivate,caps->event_port_count);
+	DSPLUG_ARENA_ARRAY(event_merge_heap,DSPlug_EventMergeEntry,caps->event_port_count);
+	DSPLUG_ARENA_ARRAY(control_ports,DSPlug_ControlPortPrivate,cp);
+	DSPLUG_ARENA_ARRAY(smoothed_control_ports,int,p_smoothed+1);
+	DSPLUG_ARENA_ARRAY(modulated_control_ports,int,cp+1);
+	DSPLUG_ARENA_ARRAY(async_data_ports,int,p_async+1);
+	DSPLUG_ARENA_ARRAY(managed_string_ports,int,p_managed+1);
+	DSPLUG_ARENA_ARRAY(modulation_batch_ports,int,cp+1);
+	DSPLUG_ARENA_ARRAY(modulation_batch_values,float,cp+1);
+	DSPLUG_ARENA_ARRAY(state_batch_ports,int,cp+1);
+	DSPLUG_ARENA_ARRAY(state_batch_values,float,cp+1);
+	DSPLUG_ARENA_ARRAY(state_batch_slots,int,cp+1);
+	DSPLUG_ARENA_ARRAY(port_generations,volatile unsigned int,cp+1);
+	DSPLUG_ARENA_ARRAY(change_log,DSPlug_ChangeLogEntry,log_size);
+	DSPLUG_ARENA_ARRAY(UI_dirty,volatile unsigned int,words+1);
+	DSPLUG_ARENA_ARRAY(UI_summary,volatile unsigned int,(words+31)/32+1);
+
+#undef DSPLUG_ARENA_ARRAY
+
+	/* channel pointer arrays and string buffers are shared among the ports */
+	if (plugin_private) {
+
+		for (i=0;i<caps->audio_port_count;i++) {
+
+			plugin_private->audio_ports[i].channel_buffer_ptr=channels;
+			channels+=caps->audio_port_caps[i]->channel_count;
+		}
+	}
+
+	for (i=0;i<cp;i++) {
+
+		char *buffers;
+
+		if (!caps->control_port_caps[i]->managed_string)
+			continue;
+
+		buffers=(char*)DSPlug_InstanceArena_take(p_arena,(caps->control_port_caps[i]->realtime_port_string_max_len+1)*3);
+		if (plugin_private)
+			plugin_private->control_ports[i].string_buffers=buffers;
+	}
+
+	return plugin_instance;
+}
+
 DSPlug_PluginInstance * DSPlug_PluginLibrary_get_plugin_instance( DSPlug_PluginLibrary * p_library, int i , int r, DSPlug_Boolean ui) {
 
 
@@ -165,90 +283,105 @@ DSPlug_PluginInstance * DSPlug_PluginLibrary_get_plugin_instance( DSPlug_PluginL
 		return NULL;
 	}
 
-	/* Create plugin instance */
-
-	plugin_instance = (DSPlug_PluginInstance *)malloc(sizeof(DSPlug_PluginInstance));
-
 	/* Create the Actual Plugin */
 	{
 		DSPlug_Plugin *plugin=NULL;
 		DSPlug_PluginPrivate *plugin_private=NULL;
 		DSPlug_PluginCaps aux_caps=DSPlug_PluginLibrary_get_plugin_caps(p_library,i);
 		DSPlug_PluginCapsPrivate *caps_private=(DSPlug_PluginCapsPrivate*)aux_caps._private;
+		DSPlug_InstanceArena arena;
+		int smoothed=0,async=0,managed=0;
 		int i=0,j=0;
 
 
 		/* User Data */
 
-		void * plugin_userdata = library->plugin_caps_array[i]->instance_plugin_userdata(aux_caps,r,ui);
+		void * plugin_userdata = caps_private->instance_plugin_userdata(aux_caps,r,ui);
 		if (plugin_userdata==NULL) {
 
-			free(plugin_instance);
 			DSPlug_report_error("HOST: DSPlug_PluginLibrary_get_plugin_instance - Plugin Failed Initialization");
 			return NULL;
 
 		}
 
-		plugin = (DSPlug_Plugin *)malloc(sizeof(DSPlug_Plugin));
-		plugin->_user_private = plugin_userdata;
+		/* Count the ports with special needs, then make the instance in a single block */
 
+		for (i=0;i<caps_private->control_port_count;i++) {
 
-		/* Plugin Data */
+			if (caps_private->control_port_caps[i]->smoothing_mode!=DSPLUG_SMOOTHING_NONE)
+				smoothed++;
+			if (caps_private->control_port_caps[i]->prepare_callback_data)
+				async++;
+			if (caps_private->control_port_caps[i]->managed_string)
+				managed++;
+		}
 
-		plugin_private = (DSPlug_PluginPrivate *)malloc(sizeof(DSPlug_PluginPrivate));
-		plugin_private->plugin_caps=caps_private;
-		plugin_private->sampling_rate=r;
-		/* Create the port structures */
+		arena.base=NULL;
+		arena.size=0;
+		DSPlug_PluginInstance_layout(&arena,caps_private,smoothed,async,managed);
 
-		/* * Audio Ports * */
-		plugin_private->audio_port_count=caps_private->audio_port_count;
-		plugin_private->audio_ports=(DSPlug_AudioPortPrivate**)malloc( sizeof(DSPlug_AudioPortPrivate*)*plugin_private->audio_port_count);
+		arena.base=(char*)malloc(arena.size);
+		memset(arena.base,0,arena.size);
+		arena.size=0;
+		plugin_instance=DSPlug_PluginInstance_layout(&arena,caps_private,smoothed,async,managed);
 
-		for (i=0;i<plugin_private->audio_port_count;i++) {
+		plugin = (DSPlug_Plugin *)plugin_instance->_private;
+		plugin->_user_private = plugin_userdata;
 
-			DSPlug_AudioPortPrivate* aport = plugin_private->audio_ports[i]; /* audio port */
+		/* Plugin Data, everything else starts zeroed */
 
-			aport = (DSPlug_AudioPortPrivate*)malloc( sizeof(DSPlug_AudioPortPrivate*));
-			aport->channel_count = caps_private->audio_port_caps[i]->channel_count;
-			aport->channel_buffer_ptr = (float**)malloc( sizeof(float*)*aport->channel_count);
-			for(j=0;j<aport->channel_count;j++)
-				aport->channel_buffer_ptr[j] = NULL; /* unconnected port channel by default */
-		}
+		plugin_private = (DSPlug_PluginPrivate *)plugin->_private;
+		plugin_private->sampling_rate=r;
+		plugin_private->sub_block_min_frames=1;
+
+		/* * Audio Ports * */
+
+		for (i=0;i<plugin_private->audio_port_count;i++)
+			plugin_private->audio_ports[i].channel_count = caps_private->audio_port_caps[i]->channel_count; /* channels start unconnected */
 
 		/* * Event Ports * */
-		plugin_private->event_port_count=caps_private->event_port_count;
-		plugin_private->event_ports=(DSPlug_EventPortPrivate**)malloc( sizeof(DSPlug_EventPortPrivate*)*plugin_private->event_port_count);
 
 		for (i=0;i<plugin_private->event_port_count;i++) {
 
-			plugin_private->event_ports[i] = (DSPlug_EventPortPrivate*)malloc( sizeof(DSPlug_EventPortPrivate*));
-			plugin_private->event_ports[i]->queue = NULL; /* unconnected queue by default */
+			/* transport events are generated by the library */
+			if (caps_private->event_port_caps[i]->event_type==DSPLUG_EVENT_TYPE_AUDIO && caps_private->event_port_caps[i]->common.plug_type==DSPLUG_PLUG_INPUT)
+				plugin_private->event_ports[i].generated_queue = DSPlug_EventQueue_create(
+					(caps_private->event_port_caps[i]->capacity_hint>DSPLUG_TRANSPORT_QUEUE_CAPACITY) ? caps_private->event_port_caps[i]->capacity_hint : DSPLUG_TRANSPORT_QUEUE_CAPACITY );
 
 		}
 
 		/* * Control Ports * */
 
-		plugin_private->control_port_count=caps_private->control_port_count;
-		plugin_private->control_ports=(DSPlug_ControlPortPrivate**)malloc( sizeof(DSPlug_ControlPortPrivate*)*plugin_private->control_port_count);
-
 		for (i=0;i<plugin_private->control_port_count;i++) {
 
-			plugin_private->control_ports[i] = (DSPlug_ControlPortPrivate*)malloc( sizeof(DSPlug_ControlPortPrivate*));
-			plugin_private->control_ports[i]->UI_changed_callback_userdata = NULL;
-			plugin_private->control_ports[i]->UI_changed_callback = NULL;
+			if (caps_private->control_port_caps[i]->prepare_callback_data)
+				plugin_private->async_data_ports[plugin_private->async_data_port_count++]=i;
 
-		}
-
-		plugin->_private=plugin_private;
+			if (caps_private->control_port_caps[i]->managed_string) {
 
-		/* Assign to instance */
+				DSPlug_ControlPortPrivate *port=&plugin_private->control_ports[i];
 
-		plugin_instance->_private=plugin;
+				/* all three start empty, the plugin reads the first one */
+				port->string_options[0]=port->string_options[1]=port->string_options[2]=DSPlug_find_string_option(caps_private->control_port_caps[i],"");
+				port->string_front=0;
+				port->string_middle=1;
+				port->string_back=2;
+				port->string_last=0;
+				plugin_private->managed_string_ports[plugin_private->managed_string_port_count++]=i;
+			}
 
-	}
+			/* Keep a list of the smoothed ports, to advance them without looking at the rest */
+			DSPlug_Smoother_init(&plugin_private->control_ports[i].smoother,caps_private->control_port_caps[i],r);
+			if (caps_private->control_port_caps[i]->smoothing_mode!=DSPLUG_SMOOTHING_NONE)
+				plugin_private->smoothed_control_ports[plugin_private->smoothed_control_port_count++]=i;
+		}
 
+		for (j=0;j<plugin_private->event_port_count;j++) {
 
-	/* Assign the private component */
+			if (plugin_private->event_ports[j].generated_queue)
+				DSPlug_PluginInstance_connect_event_port(plugin_instance,j,NULL);
+		}
+	}
 
 
 	return plugin_instance;
@@ -273,31 +406,52 @@ void DSPlug_PluginLibrary_destroy_plugin_instance( DSPlug_PluginLibrary *  p_lib
 		exit(255);
 	}
 
-	/* first, get rid of the programmer userdata for the plugin */
-	plugin->plugin_caps->destroy_plugin_userdata(plugin_public);
+	/* objects of asynchronous data ports belong to the plugin, release them while it's still there */
+	for (i=0;i<plugin->async_data_port_count;i++) {
 
-	for (i=0;i<plugin->audio_port_count;i++) {
+		DSPlug_ControlPortPrivate *port=&plugin->control_ports[plugin->async_data_ports[i]];
+		void (*release)(DSPlug_Plugin , int, void *)=plugin->plugin_caps->control_port_caps[plugin->async_data_ports[i]]->release_callback_data;
 
-		/* free the channel buffer connections of the port */
-		free(plugin->audio_ports[i]->channel_buffer_ptr);
-		/* free the port */
-		free(plugin->audio_ports[i]);
+		if (port->data_pending)
+			release(*plugin_public,plugin->async_data_ports[i],port->data_pending);
+		if (port->data_current)
+			release(*plugin_public,plugin->async_data_ports[i],port->data_current);
+		if (port->data_retired)
+			release(*plugin_public,plugin->async_data_ports[i],port->data_retired);
 	}
 
+	/* then, get rid of the programmer userdata for the plugin */
+	plugin->plugin_caps->destroy_plugin_userdata(plugin_public);
+
 	for (i=0;i<plugin->event_port_count;i++) {
 
-		/* free the port */
-		free(plugin->event_ports[i]);
-	}
+		/* the producers of connected queues must stop notifying us, this waits for a push in progress */
+		if (plugin->event_ports[i].queue)
+			DSPlug_EventQueue_clear_pending_flag(plugin->event_ports[i].queue,&plugin->pending_input_event_ports[i/32],1U<<(i%32));
 
-	for (i=0;i<plugin->control_port_count;i++) {
+		if (plugin->event_ports[i].generated_queue)
+			DSPlug_EventQueue_destroy(plugin->event_ports[i].generated_queue);
+	}
 
-		/* free the port */
-		free(plugin->control_ports[i]);
+	/* automation_latest is always one of these */
+	if (plugin->automation)
+		DSPlug_Automation_destroy(plugin->automation);
+	if (plugin->automation_pending)
+		DSPlug_Automation_destroy((DSPlug_AutomationPrivate*)plugin->automation_pending);
+	if (plugin->automation_retired)
+		DSPlug_Automation_destroy((DSPlug_AutomationPrivate*)plugin->automation_retired);
+
+	if (plugin->mailbox_values) {
+
+		free((void*)plugin->mailbox_values);
+		free((void*)plugin->mailbox_dirty);
+		free((void*)plugin->mailbox_summary);
+		free(plugin->mailbox_batch_ports);
+		free(plugin->mailbox_batch_values);
 	}
 
-	free(plugin);
-	free(plugin_public);
+	/* the instance is the beginning of the block holding everything else */
+	free(p_instance);
 
 	/* Successful Deinitialization! */
 }
@@ -629,6 +783,87 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
  }
 
 
+ int DSPlug_PluginCaps_find_port( DSPlug_PluginCaps p_caps, DSPlug_PortType t, const char *s ) {
+
+	 DSPlug_PluginCapsPrivate *caps = (DSPlug_PluginCapsPrivate *)p_caps._private;
+	 DSPlug_CommonPortCapsPrivate **common_port_caps;
+	 if (caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginCaps_find_port: Calling with NULL PluginCaps object ");
+		 return -1;
+	 }
+
+	 if (!s) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginCaps_find_port: NULL port name ");
+		 return -1;
+	 }
+
+	 switch (t) {
+		 case DSPLUG_PORT_AUDIO: {
+			 common_port_caps = (DSPlug_CommonPortCapsPrivate **)caps->audio_port_caps;
+		 } break;
+		 case DSPLUG_PORT_EVENT: {
+			 common_port_caps = (DSPlug_CommonPortCapsPrivate **)caps->event_port_caps;
+		 } break;
+		 case DSPLUG_PORT_CONTROL: {
+			 common_port_caps = (DSPlug_CommonPortCapsPrivate **)caps->control_port_caps;
+		 } break;
+		 default: {
+			 DSPlug_report_error("HOST: DSPlug_PluginCaps_find_port: Invalid port type ");
+			 return -1;
+		 }
+	 }
+
+	 return DSPlug_find_port_index(&caps->port_index[t],common_port_caps,s);
+ }
+
+ int DSPlug_PluginCaps_get_musical_part_count( DSPlug_PluginCaps p_caps ) {
+
+	 DSPlug_PluginCapsPrivate *caps = (DSPlug_PluginCapsPrivate *)p_caps._private;
+
+	 if (caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginCaps_get_musical_part_count: Calling with NULL PluginCaps object ");
+		 return 0;
+	 }
+
+	 return caps->musical_part_count;
+ }
+
+ int DSPlug_PluginCaps_get_musical_part_port_count( DSPlug_PluginCaps p_caps, int n ) {
+
+	 DSPlug_PluginCapsPrivate *caps = (DSPlug_PluginCapsPrivate *)p_caps._private;
+
+	 if (caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginCaps_get_musical_part_port_count: Calling with NULL PluginCaps object ");
+		 return 0;
+	 }
+
+	 if (n<0 || n>=caps->musical_part_count)
+		 return 0;
+
+	 return caps->musical_part_offsets[n+1]-caps->musical_part_offsets[n];
+ }
+
+ int DSPlug_PluginCaps_get_musical_part_port( DSPlug_PluginCaps p_caps, int n, int x ) {
+
+	 DSPlug_PluginCapsPrivate *caps = (DSPlug_PluginCapsPrivate *)p_caps._private;
+
+	 if (caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginCaps_get_musical_part_port: Calling with NULL PluginCaps object ");
+		 return -1;
+	 }
+
+	 if (n<0 || n>=caps->musical_part_count || x<0 || x>=caps->musical_part_offsets[n+1]-caps->musical_part_offsets[n])
+		 return -1;
+
+	 return caps->musical_part_ports[caps->musical_part_offsets[n]+x];
+ }
+
+
  DSPlug_AudioPortCaps DSPlug_PluginCaps_get_audio_port_caps( DSPlug_PluginCaps p_caps, int i ) {
 
 	 DSPlug_PluginCapsPrivate *caps = (DSPlug_PluginCapsPrivate *)p_caps._private;
@@ -742,6 +977,19 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
 
  }
 
+ int DSPlug_EventPortCaps_get_capacity_hint( DSPlug_EventPortCaps p_event_caps ) {
+
+	 DSPlug_EventPortCapsPrivate *event_caps = (DSPlug_EventPortCapsPrivate *)p_event_caps._private;
+	 if (event_caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_EventPortCaps_get_capacity_hint: Calling with NULL EventPortCaps ");
+		 return 0; /* return something */
+	 }
+
+	 return event_caps->capacity_hint;
+
+ }
+
  /****************************/
 
  /* CONTROL PORT CAPS */
@@ -937,6 +1185,67 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
  }
 
 
+ int DSPlug_ControlPortCaps_get_string_option_count( DSPlug_ControlPortCaps p_control_caps ) {
+
+	 DSPlug_ControlPortCapsPrivate *control_caps = (DSPlug_ControlPortCapsPrivate *)p_control_caps._private;
+
+	 if (control_caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_string_option_count: Calling with NULL ControlPortCaps ");
+		 return 0; /* return anything */
+	 }
+
+	 return control_caps->string_option_count;
+ }
+
+ const char * DSPlug_ControlPortCaps_get_string_option( DSPlug_ControlPortCaps p_control_caps, int i ) {
+
+	 DSPlug_ControlPortCapsPrivate *control_caps = (DSPlug_ControlPortCapsPrivate *)p_control_caps._private;
+
+	 if (control_caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_string_option: Calling with NULL ControlPortCaps ");
+		 return NULL; /* return anything */
+	 }
+
+	 if (i<0 || i>=control_caps->string_option_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_string_option: Invalid option index ");
+		 return NULL;
+	 }
+
+	 return control_caps->string_options[i];
+ }
+
+
+ DSPlug_Boolean DSPlug_ControlPortCaps_is_data_async( DSPlug_ControlPortCaps p_control_caps ) {
+
+	 DSPlug_ControlPortCapsPrivate *control_caps = (DSPlug_ControlPortCapsPrivate *)p_control_caps._private;
+
+	 if (control_caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_is_data_async: Calling with NULL ControlPortCaps ");
+		 return DSPLUG_FALSE; /* return anything */
+	 }
+
+	 return control_caps->prepare_callback_data ? DSPLUG_TRUE : DSPLUG_FALSE;
+ }
+
+
+ DSPlug_Boolean DSPlug_ControlPortCaps_has_modulation_input( DSPlug_ControlPortCaps p_control_caps ) {
+
+	 DSPlug_ControlPortCapsPrivate *control_caps = (DSPlug_ControlPortCapsPrivate *)p_control_caps._private;
+
+	 if (control_caps==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_has_modulation_input: Calling with NULL ControlPortCaps ");
+		 return DSPLUG_FALSE; /* return anything */
+	 }
+
+	 return control_caps->modulation_input;
+ }
+
+
  int DSPlug_ControlPortCaps_get_music_part( DSPlug_ControlPortCaps p_control_caps ) {
 
 	 DSPlug_ControlPortCapsPrivate *control_caps = (DSPlug_ControlPortCapsPrivate *)p_control_caps._private;
@@ -944,10 +1253,10 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
 	 if (control_caps==NULL) {
 
 		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_musical_part: Calling with NULL ControlPortCaps ");
-		 return 0; /* return anything */
+		 return -1; /* return anything */
 	 }
 
-	 return control_caps->musical_part;
+	 return control_caps->musical_part-1; /* stored plus one */
 
  }
 
@@ -981,13 +1290,13 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
 		 return ; /* return anything */
 	 }
 
-	 if (c<0 || c>=plugin->audio_ports[i]->channel_count) {
+	 if (c<0 || c>=plugin->audio_ports[i].channel_count) {
 
 		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_connect_audio_port: Invalid Audio Port Channel Index ");
 		 return ; /* return anything */
 	 }
 
-	 plugin->audio_ports[i]->channel_buffer_ptr[c]=b;
+	 plugin->audio_ports[i].channel_buffer_ptr[c]=b;
  }
 
 
@@ -995,6 +1304,7 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_EventQueue *old_queue;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
@@ -1008,7 +1318,28 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
 		 return ; /* return anything */
 	 }
 
-	 plugin->event_ports[i]->queue=q;
+	 if (!q)
+		 q=plugin->event_ports[i].generated_queue; /* may be NULL too */
+
+	 old_queue=plugin->event_ports[i].queue;
+	 plugin->event_ports[i].queue=q;
+
+	 /* Have the queues of the inputs tell when they have events, for merging them */
+	 if (plugin->plugin_caps->event_port_caps[i]->common.plug_type==DSPLUG_PLUG_INPUT) {
+
+		 volatile unsigned int *word=&plugin->pending_input_event_ports[i/32];
+		 unsigned int bit=1U<<(i%32);
+
+		 if (old_queue && old_queue!=q)
+			 DSPlug_EventQueue_clear_pending_flag(old_queue,word,bit);
+
+		 plugin->polled_input_event_ports[i/32]&=~bit;
+
+		 if (!q)
+			 DSPLUG_ATOMIC_FETCH_AND(word,~bit);
+		 else if (!DSPlug_EventQueue_set_pending_flag(q,word,bit))
+			 plugin->polled_input_event_ports[i/32]|=bit; /* shared queue, already notifying another port */
+	 }
 
  }
 
@@ -1042,7 +1373,9 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
 
 	 if (plugin->plugin_caps->control_port_caps[i]->set_callback_numerical) {
 
+		 DSPlug_Smoother_set_target(&plugin->control_ports[i].smoother,plugin->plugin_caps->control_port_caps[i],v);
 		 plugin->plugin_caps->control_port_caps[i]->set_callback_numerical(*plugin_public,i,v);
+		 DSPlug_mark_control_port_changed(plugin,i);
 	 } else {
 
 		 DSPlug_report_error("API: DSPlug_ControlPortCaps_set_control_numerical_port: Control Port not configured, Bug? ");
@@ -1051,295 +1384,1572 @@ int DSPlug_PluginCaps_get_constant( DSPlug_PluginCaps p_caps , DSPlug_PluginCons
  }
 
 
- void DSPlug_PluginInstance_set_control_string_port( DSPlug_PluginInstance *p_instance, int i , const char * s ) {
+ void DSPlug_PluginInstance_set_musical_part_numerical_port( DSPlug_PluginInstance *p_instance, int n, int x, float v ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_PluginCapsPrivate *caps;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_connect_event_port: Calling with NULL PluginInstance ");
-		 return ; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_musical_part_numerical_port: Calling with NULL PluginInstance ");
+		 return ;
 	 }
 
-	 if (i<0 || i>=plugin->control_port_count) {
+	 caps=plugin->plugin_caps;
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_string_port: Invalid Control Port Index ");
-		 return ; /* return anything */
+	 if (n<0 || n>=caps->musical_part_count || x<0 || x>=caps->musical_part_offsets[n+1]-caps->musical_part_offsets[n]) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_musical_part_numerical_port: Invalid Musical Part or Port ");
+		 return ;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_STRING) {
+	 DSPlug_PluginInstance_set_control_numerical_port(p_instance,caps->musical_part_ports[caps->musical_part_offsets[n]+x],v);
+ }
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_string_port: Port is not of string type ");
-		 return ; /* return anything */
 
-	 }
+ /* Set validated numerical input ports */
+ static void DSPlug_PluginInstance_dispatch_numerical_batch( DSPlug_Plugin *plugin_public, DSPlug_PluginPrivate *plugin, const int *p, const float *v, int n ) {
 
-	 if (plugin->plugin_caps->control_port_caps[i]->set_callback_string) {
+	 DSPlug_ControlPortCapsPrivate **caps=plugin->plugin_caps->control_port_caps;
+	 int i;
 
-		 plugin->plugin_caps->control_port_caps[i]->set_callback_string(*plugin_public,i,s);
-	 } else {
+	 for (i=0;i<n;i++) {
 
-		 DSPlug_report_error("API: DSPlug_ControlPortCaps_set_string_string_port: Control Port not configured, Bug? ");
+		 DSPlug_Smoother_set_target(&plugin->control_ports[p[i]].smoother,caps[p[i]],v[i]);
+		 DSPlug_mark_control_port_changed(plugin,p[i]);
 	 }
 
+	 if (plugin->plugin_caps->set_numerical_batch_callback) {
 
- }
+		 plugin->plugin_caps->set_numerical_batch_callback(*plugin_public,p,v,n);
+		 return;
+	 }
 
+	 for (i=0;i<n;i++)
+		 caps[p[i]]->set_callback_numerical(*plugin_public,p[i],v[i]);
+ }
 
- void DSPlug_PluginInstance_set_control_data_port( DSPlug_PluginInstance *p_instance, int i , const void * d, int l ) {
+ void DSPlug_PluginInstance_set_control_numerical_ports( DSPlug_PluginInstance *p_instance, const int *p , const float *v, int n ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_ControlPortCapsPrivate **caps;
+	 int i;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_data_port: Calling with NULL PluginInstance ");
-		 return ; /* return anything */
-	 }
-
-	 if (i<0 || i>=plugin->control_port_count) {
-
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_data_port: Invalid Control Port Index ");
-		 return ; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_numerical_ports: Calling with NULL PluginInstance ");
+		 return ;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_DATA) {
+	 if (n<=0)
+		 return;
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_data_port: Port is not of data type ");
-		 return ; /* return anything */
+	 if (!p || !v) {
 
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_numerical_ports: NULL port or value array ");
+		 return ;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->set_callback_data) {
+	 caps=plugin->plugin_caps->control_port_caps;
 
-		 plugin->plugin_caps->control_port_caps[i]->set_callback_data(*plugin_public,i,d,l);
-	 } else {
+	 for (i=0;i<n;i++) {
 
-		 DSPlug_report_error("API: DSPlug_ControlPortCaps_set_data_data_port: Control Port not configured, Bug? ");
-	 }
+		 if (p[i]<0 || p[i]>=plugin->control_port_count || caps[p[i]]->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL || !caps[p[i]]->set_callback_numerical) {
 
+			 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_numerical_ports: Invalid port index, or not a numerical port, nothing was set ");
+			 return ;
+		 }
+	 }
 
+	 DSPlug_PluginInstance_dispatch_numerical_batch(plugin_public,plugin,p,v,n);
  }
 
-
-
- float DSPlug_PluginInstance_get_control_numerical_port( DSPlug_PluginInstance *p_instance, int i ) {
+ void DSPlug_PluginInstance_connect_control_port_modulation( DSPlug_PluginInstance *p_instance, int i, const float *b ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_ControlPortCapsPrivate *caps;
+	 DSPlug_ControlPortPrivate *port;
+	 int j;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_numerical_port: Calling with NULL PluginInstance ");
-		 return 0; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_connect_control_port_modulation: Calling with NULL PluginInstance ");
+		 return ;
 	 }
 
 	 if (i<0 || i>=plugin->control_port_count) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_numerical_port: Invalid Control Port Index ");
-		 return 0; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_connect_control_port_modulation: Invalid Control Port Index ");
+		 return ;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL) {
+	 caps=plugin->plugin_caps->control_port_caps[i];
+	 port=&plugin->control_ports[i];
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_numerical_port: Port is not of numerical type ");
-		 return 0; /* return anything */
+	 if (caps->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL || caps->common.plug_type!=DSPLUG_PLUG_INPUT || !caps->set_callback_numerical) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_connect_control_port_modulation: Only numerical input ports can be modulated ");
+		 return ;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->set_callback_numerical) {
+	 /* Not synchronized with processing, which walks the list, see the header */
+	 if (b && !port->modulation_buffer) {
 
-		 return plugin->plugin_caps->control_port_caps[i]->get_callback_numerical(*plugin_public,i);
-	 } else {
+		 plugin->modulated_control_ports[plugin->modulated_control_port_count++]=i;
 
-		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_numerical_port: Control Port not configured, Bug? ");
-		 return 0;
+	 } else if (!b && port->modulation_buffer) {
+
+		 for (j=0;j<plugin->modulated_control_port_count;j++) {
+
+			 if (plugin->modulated_control_ports[j]==i) {
+
+				 plugin->modulated_control_ports[j]=plugin->modulated_control_ports[--plugin->modulated_control_port_count];
+				 break;
+			 }
+		 }
 	 }
+
+	 port->modulation_buffer=b;
+	 port->modulation_buffer_ptr=b;
  }
 
+ /* CHANGE TRACKING */
 
- char * DSPlug_PluginInstance_get_control_string_port( DSPlug_PluginInstance *p_instance, int i ) {
+ unsigned int DSPlug_PluginInstance_get_change_generation( DSPlug_PluginInstance *p_instance ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Calling with NULL PluginInstance ");
-		 return NULL; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_change_generation: Calling with NULL PluginInstance ");
+		 return 0;
 	 }
 
-	 if (i<0 || i>=plugin->control_port_count) {
+	 return plugin->change_generation;
+ }
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Invalid Control Port Index ");
-		 return NULL; /* return anything */
+ unsigned int DSPlug_PluginInstance_get_control_port_generation( DSPlug_PluginInstance *p_instance, int i ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_port_generation: Calling with NULL PluginInstance ");
+		 return 0;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_STRING) {
+	 if (i<0 || i>=plugin->control_port_count) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Port is not of string type ");
-		 return NULL; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_port_generation: Invalid Control Port Index ");
+		 return 0;
+	 }
+
+	 return plugin->port_generations[i];
+ }
 
+ /* The changes since g are no longer in the log, compare the generation of every port */
+ static int DSPlug_PluginInstance_scan_changed_control_ports( DSPlug_PluginPrivate *plugin, unsigned int g, int *p ) {
+
+	 unsigned int generation;
+	 int i,n=0;
+
+	 for (i=0;i<plugin->control_port_count;i++) {
+
+		 generation=plugin->port_generations[i];
+
+		 if (generation && (int)(generation-g)>0)
+			 p[n++]=i;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->is_realtime_safe) {
+	 return n;
+ }
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Port is of type realtime safe, not allowing call. ");
-		 return NULL; /* return anything */
+ int DSPlug_PluginInstance_get_changed_control_ports( DSPlug_PluginInstance *p_instance, unsigned int g, int *p, unsigned int *r ) {
 
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_ChangeLogEntry *entry;
+	 unsigned int current,next,generation;
+	 int port,n=0;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_changed_control_ports: Calling with NULL PluginInstance ");
+		 return 0;
 	 }
 
+	 if (!p || !r) {
 
-	 if (plugin->plugin_caps->control_port_caps[i]->get_callback_string) {
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_changed_control_ports: NULL port array or generation ");
+		 return 0;
+	 }
 
-		 return plugin->plugin_caps->control_port_caps[i]->get_callback_string(*plugin_public,i);
-	 } else {
+	 current=plugin->change_generation;
 
-		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_string_port: Control Port not configured, Bug? ");
-		 return NULL;
+	 if (current-g>plugin->change_log_mask) {
+
+		 *r=current;
+		 return DSPlug_PluginInstance_scan_changed_control_ports(plugin,g,p);
 	 }
 
+	 for (next=g+1;next!=current+1;next++) {
+
+		 if (next==0) /* never given */
+			 continue;
+
+		 entry=&plugin->change_log[next&plugin->change_log_mask];
+		 generation=entry->generation;
 
+		 if ((int)(generation-next)<0)
+			 break; /* still being written, the rest is left for the next call */
 
+		 DSPLUG_MEMORY_BARRIER();
+		 port=entry->port;
+		 DSPLUG_MEMORY_BARRIER();
+
+		 if (generation!=next || entry->generation!=next) {
+
+			 /* overwritten while reading, too many changes */
+			 *r=current;
+			 return DSPlug_PluginInstance_scan_changed_control_ports(plugin,g,p);
+		 }
+
+		 /* a port is only listed at its last change */
+		 if (plugin->port_generations[port]==next)
+			 p[n++]=port;
+	 }
+
+	 *r=next-1;
+	 return n;
  }
 
- void DSPlug_PluginInstance_get_control_string_port_realtime( DSPlug_PluginInstance *p_instance, int i , char * s ) {
+ /* CONTROL MAILBOX */
+
+ void DSPlug_PluginInstance_set_control_mailbox( DSPlug_PluginInstance *p_instance, DSPlug_Boolean e ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 int words;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Calling with NULL PluginInstance ");
-		 return ; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_mailbox: Calling with NULL PluginInstance ");
+		 return ;
 	 }
 
-	 if (i<0 || i>=plugin->control_port_count) {
+	 if (plugin->inside_process_callback_flag) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Invalid Control Port Index ");
-		 return ; /* return anything */
+		 DSPlug_report_error("API: DSPlug_PluginInstance_set_control_mailbox: Can't be called while processing ");
+		 return ;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_STRING) {
+	 if (e && !plugin->mailbox_values) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Port is not of string type ");
-		 return ; /* return anything */
+		 words=(plugin->control_port_count+31)/32;
+
+		 plugin->mailbox_values=(volatile float*)malloc(sizeof(float)*(plugin->control_port_count+1));
+		 plugin->mailbox_dirty=(volatile unsigned int*)malloc(sizeof(unsigned int)*(words+1));
+		 memset((void*)plugin->mailbox_dirty,0,sizeof(unsigned int)*(words+1));
+		 plugin->mailbox_summary_words=(words+31)/32;
+		 plugin->mailbox_summary=(volatile unsigned int*)malloc(sizeof(unsigned int)*(plugin->mailbox_summary_words+1));
+		 memset((void*)plugin->mailbox_summary,0,sizeof(unsigned int)*(plugin->mailbox_summary_words+1));
+		 plugin->mailbox_batch_ports=(int*)malloc(sizeof(int)*(plugin->control_port_count+1));
+		 plugin->mailbox_batch_values=(float*)malloc(sizeof(float)*(plugin->control_port_count+1));
 
+	 } else if (!e && plugin->mailbox_values) {
+
+		 free((void*)plugin->mailbox_values);
+		 free((void*)plugin->mailbox_dirty);
+		 free((void*)plugin->mailbox_summary);
+		 free(plugin->mailbox_batch_ports);
+		 free(plugin->mailbox_batch_values);
+		 plugin->mailbox_values=NULL;
+		 plugin->mailbox_dirty=NULL;
+		 plugin->mailbox_summary=NULL;
+		 plugin->mailbox_summary_words=0;
 	 }
+ }
 
-	 if (!plugin->plugin_caps->control_port_caps[i]->is_realtime_safe) {
+ void DSPlug_PluginInstance_post_control_numerical_port( DSPlug_PluginInstance *p_instance, int i , float v ) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Port is not realtime safe, not allowing call. ");
-		 return ; /* return anything */
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
 
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_post_control_numerical_port: Calling with NULL PluginInstance ");
+		 return ;
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->get_callback_string) {
+	 if (!plugin->mailbox_values) {
 
-		 plugin->plugin_caps->control_port_caps[i]->get_callback_string_realtime(*plugin_public,i,s);
-	 } else {
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_post_control_numerical_port: Control mailbox is not enabled ");
+		 return ;
+	 }
 
-		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_string_port_realtime: Control Port not configured, Bug? ");
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_post_control_numerical_port: Invalid Control Port Index ");
+		 return ;
 	 }
 
+	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL || !plugin->plugin_caps->control_port_caps[i]->set_callback_numerical) {
 
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_post_control_numerical_port: Port is not a settable numerical port ");
+		 return ;
+	 }
 
+	 /* value first, then the dirty bits that make the drain read it */
+	 plugin->mailbox_values[i]=v;
+	 DSPLUG_MEMORY_BARRIER();
+	 DSPLUG_ATOMIC_FETCH_OR(&plugin->mailbox_dirty[i/32],1U<<(i%32));
+	 DSPLUG_ATOMIC_FETCH_OR(&plugin->mailbox_summary[i/1024],1U<<((i/32)%32));
  }
 
 
- void DSPlug_PluginInstance_get_control_port_data( DSPlug_PluginInstance *p_instance, int i , void ** d, int * l ) {
+ /* MANAGED STRING PORTS */
+
+ #define DSPLUG_STRING_BUFFER_FRESH 4 /* ORed to the middle buffer index, until the audio thread takes it */
+
+ static int DSPlug_atomic_exchange_int( volatile int *p, int v ) {
+
+	 int old;
+
+	 do {
+		 old=*p;
+	 } while (!DSPLUG_ATOMIC_CAS(p,old,v));
+
+	 return old;
+ }
+
+ /* Called from the single thread that sets strings, never waits nor allocates */
+ static void DSPlug_PluginInstance_set_managed_string( DSPlug_ControlPortCapsPrivate *caps, DSPlug_ControlPortPrivate *port, const char *s ) {
+
+	 int size=caps->realtime_port_string_max_len+1;
+	 char *buffer=&port->string_buffers[port->string_back*size];
+
+	 strncpy(buffer,s,size-1);
+	 buffer[size-1]=0;
+	 port->string_options[port->string_back]=DSPlug_find_string_option(caps,buffer);
+	 port->string_last=port->string_back;
+
+	 /* publish it, and take whatever was there to write the next one */
+	 port->string_back=DSPlug_atomic_exchange_int(&port->string_middle,port->string_back|DSPLUG_STRING_BUFFER_FRESH)&~DSPLUG_STRING_BUFFER_FRESH;
+ }
+
+ static void DSPlug_PluginInstance_swap_managed_strings( DSPlug_PluginPrivate *plugin ) {
+
+	 DSPlug_ControlPortPrivate *port;
+	 int i;
+
+	 for (i=0;i<plugin->managed_string_port_count;i++) {
+
+		 port=&plugin->control_ports[plugin->managed_string_ports[i]];
+
+		 if (!(port->string_middle&DSPLUG_STRING_BUFFER_FRESH))
+			 continue;
+
+		 port->string_front=DSPlug_atomic_exchange_int(&port->string_middle,port->string_front)&~DSPLUG_STRING_BUFFER_FRESH;
+	 }
+ }
+
+
+ void DSPlug_PluginInstance_set_control_string_port( DSPlug_PluginInstance *p_instance, int i , const char * s ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_data_port: Calling with NULL PluginInstance ");
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_connect_event_port: Calling with NULL PluginInstance ");
 		 return ; /* return anything */
 	 }
 
 	 if (i<0 || i>=plugin->control_port_count) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_data_port: Invalid Control Port Index ");
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_string_port: Invalid Control Port Index ");
 		 return ; /* return anything */
 	 }
 
 	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_STRING) {
 
-		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_data_port: Port is not of data type ");
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_string_port: Port is not of string type ");
 		 return ; /* return anything */
 
 	 }
 
-	 if (plugin->plugin_caps->control_port_caps[i]->get_callback_data) {
+	 if (plugin->plugin_caps->control_port_caps[i]->managed_string) {
 
-		 plugin->plugin_caps->control_port_caps[i]->get_callback_data(*plugin_public,i,d,l);
+		 DSPlug_PluginInstance_set_managed_string(plugin->plugin_caps->control_port_caps[i],&plugin->control_ports[i],s ? s : "");
+		 DSPlug_mark_control_port_changed(plugin,i);
+
+	 } else if (plugin->plugin_caps->control_port_caps[i]->set_callback_string) {
+
+		 plugin->plugin_caps->control_port_caps[i]->set_callback_string(*plugin_public,i,s);
+		 DSPlug_mark_control_port_changed(plugin,i);
 	 } else {
 
-		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_data_port: Control Port not configured, Bug? ");
+		 DSPlug_report_error("API: DSPlug_ControlPortCaps_set_string_string_port: Control Port not configured, Bug? ");
 	 }
 
 
  }
 
 
- void DSPlug_PluginInstance_set_UI_changed_control_port_callback( DSPlug_PluginInstance *p_instance, int i , void (*c)(int, void *) , void * u) {
+ void DSPlug_PluginInstance_set_control_data_port( DSPlug_PluginInstance *p_instance, int i , const void * d, int l ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_port_changed_callback: Calling with NULL PluginInstance ");
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_data_port: Calling with NULL PluginInstance ");
 		 return ; /* return anything */
 	 }
 
 	 if (i<0 || i>=plugin->control_port_count) {
 
-		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_port_changed_callback: Invalid Control Port Index ");
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_data_port: Invalid Control Port Index ");
+		 return ; /* return anything */
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_DATA) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_set_control_data_port: Port is not of data type ");
 		 return ; /* return anything */
+
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->set_callback_data) {
+
+		 plugin->plugin_caps->control_port_caps[i]->set_callback_data(*plugin_public,i,d,l);
+		 DSPlug_mark_control_port_changed(plugin,i);
+	 } else {
+
+		 DSPlug_report_error("API: DSPlug_ControlPortCaps_set_data_data_port: Control Port not configured, Bug? ");
 	 }
 
-	 plugin->control_ports[i]->UI_changed_callback=c;
-	 plugin->control_ports[i]->UI_changed_callback_userdata=u;
 
  }
 
 
+ /* ASYNCHRONOUS DATA PORTS */
 
- /****************************/
+ static void * DSPlug_atomic_exchange_pointer( void * volatile *p, void *v ) {
 
- /* PROCESSING THE AUDIO */
+	 void *old;
 
- /****************************/
+	 do {
+		 old=*p;
+	 } while (!DSPLUG_ATOMIC_CAS(p,old,v));
 
- void DSPlug_PluginInstance_process( DSPlug_PluginInstance *p_instance, int f ) {
+	 return old;
+ }
+
+ void DSPlug_PluginInstance_set_control_data_port_async( DSPlug_PluginInstance *p_instance, int i , const void * d, int l ) {
 
 	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_ControlPortCapsPrivate *caps;
+	 void *object;
 
 	 if (plugin_public==NULL || plugin==NULL) {
 
-		 DSPlug_report_error("HOST: DSPlug_PluginInstance_process: Calling with NULL PluginInstance ");
-		 return ; /* return anything */
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_data_port_async: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_data_port_async: Invalid Control Port Index ");
+		 return ;
+	 }
+
+	 caps=plugin->plugin_caps->control_port_caps[i];
+
+	 if (caps->type!=DSPLUG_CONTROL_PORT_TYPE_DATA || !caps->prepare_callback_data) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_data_port_async: Port is not an asynchronous data port ");
+		 return ;
+	 }
+
+	 object=caps->prepare_callback_data(*plugin_public,i,d,l);
+
+	 if (!object)
+		 return; /* plugin refused the data */
+
+	 /* Publish, if the last one wasn't taken yet, nobody will take it now */
+	 object=DSPlug_atomic_exchange_pointer(&plugin->control_ports[i].data_pending,object);
+
+	 if (object)
+		 caps->release_callback_data(*plugin_public,i,object);
+
+	 DSPlug_mark_control_port_changed(plugin,i);
+	 DSPlug_PluginInstance_collect_retired_data(p_instance);
+ }
+
+ void DSPlug_PluginInstance_collect_retired_data( DSPlug_PluginInstance *p_instance ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 void *object;
+	 int i,port;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_collect_retired_data: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 for (i=0;i<plugin->async_data_port_count;i++) {
+
+		 port=plugin->async_data_ports[i];
+
+		 if (!plugin->control_ports[port].data_retired)
+			 continue;
+
+		 object=DSPlug_atomic_exchange_pointer(&plugin->control_ports[port].data_retired,NULL);
+
+		 if (object)
+			 plugin->plugin_caps->control_port_caps[port]->release_callback_data(*plugin_public,port,object);
+	 }
+
+	 if (plugin->automation_retired) {
+
+		 object=DSPlug_atomic_exchange_pointer(&plugin->automation_retired,NULL);
+
+		 if (object)
+			 DSPlug_Automation_destroy((DSPlug_AutomationPrivate*)object);
+	 }
+ }
+
+ /* Take the published objects, at the beginning of a cycle */
+ static void DSPlug_PluginInstance_swap_async_data( DSPlug_PluginPrivate *plugin ) {
+
+	 DSPlug_ControlPortPrivate *port;
+	 void *object;
+	 int i;
+
+	 for (i=0;i<plugin->async_data_port_count;i++) {
+
+		 port=&plugin->control_ports[plugin->async_data_ports[i]];
+
+		 /* the replaced object can't be freed here, wait until the host releases the last one */
+		 if (!port->data_pending || port->data_retired)
+			 continue;
+
+		 object=DSPlug_atomic_exchange_pointer(&port->data_pending,NULL);
+
+		 if (!object)
+			 continue;
+
+		 if (port->data_current)
+			 DSPlug_atomic_exchange_pointer(&port->data_retired,port->data_current); /* published, the host may free it any time now */
+
+		 port->data_current=object;
+	 }
+ }
+
+
+ float DSPlug_PluginInstance_get_control_numerical_port( DSPlug_PluginInstance *p_instance, int i ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_numerical_port: Calling with NULL PluginInstance ");
+		 return 0; /* return anything */
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_numerical_port: Invalid Control Port Index ");
+		 return 0; /* return anything */
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_numerical_port: Port is not of numerical type ");
+		 return 0; /* return anything */
 	 }
 
-	 if (plugin->plugin_caps->process_callback && plugin->inside_process_callback_flag) {
+	 if (plugin->plugin_caps->control_port_caps[i]->set_callback_numerical) {
 
-		 plugin->inside_process_callback_flag=DSPLUG_TRUE;
-		 plugin->plugin_caps->process_callback(plugin_public,f);
-		 plugin->inside_process_callback_flag=DSPLUG_FALSE;
+		 return plugin->plugin_caps->control_port_caps[i]->get_callback_numerical(*plugin_public,i);
 	 } else {
 
-		 if (plugin->inside_process_callback_flag)
-			 DSPlug_report_error("API: DSPlug_PluginInstance_process: Attempt to call process() when already processing! ");
-		 else
-			 DSPlug_report_error("API: DSPlug_PluginInstance_process: Plugin lacks process() callback, bug? ");
+		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_numerical_port: Control Port not configured, Bug? ");
+		 return 0;
 	 }
  }
 
 
+ char * DSPlug_PluginInstance_get_control_string_port( DSPlug_PluginInstance *p_instance, int i ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Calling with NULL PluginInstance ");
+		 return NULL; /* return anything */
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Invalid Control Port Index ");
+		 return NULL; /* return anything */
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_STRING) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Port is not of string type ");
+		 return NULL; /* return anything */
+
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->is_realtime_safe) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port: Port is of type realtime safe, not allowing call. ");
+		 return NULL; /* return anything */
+
+	 }
+
+
+	 if (plugin->plugin_caps->control_port_caps[i]->get_callback_string) {
+
+		 return plugin->plugin_caps->control_port_caps[i]->get_callback_string(*plugin_public,i);
+	 } else {
 
+		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_string_port: Control Port not configured, Bug? ");
+		 return NULL;
+	 }
+
+
+
+ }
+
+ void DSPlug_PluginInstance_get_control_string_port_realtime( DSPlug_PluginInstance *p_instance, int i , char * s ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Calling with NULL PluginInstance ");
+		 return ; /* return anything */
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Invalid Control Port Index ");
+		 return ; /* return anything */
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_STRING) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Port is not of string type ");
+		 return ; /* return anything */
+
+	 }
+
+	 if (!plugin->plugin_caps->control_port_caps[i]->is_realtime_safe) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_string_port_realtime: Port is not realtime safe, not allowing call. ");
+		 return ; /* return anything */
+
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->managed_string) {
+
+		 int size=plugin->plugin_caps->control_port_caps[i]->realtime_port_string_max_len+1;
+
+		 memcpy(s,&plugin->control_ports[i].string_buffers[plugin->control_ports[i].string_last*size],size);
+
+	 } else if (plugin->plugin_caps->control_port_caps[i]->get_callback_string_realtime) {
+
+		 plugin->plugin_caps->control_port_caps[i]->get_callback_string_realtime(*plugin_public,i,s);
+	 } else {
+
+		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_string_port_realtime: Control Port not configured, Bug? ");
+	 }
+
+
+
+ }
+
+
+ int DSPlug_PluginInstance_get_control_string_port_realtime_max_length( DSPlug_PluginInstance *p_instance, int i ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_string_port_realtime_max_length: Calling with NULL PluginInstance ");
+		 return 0;
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_string_port_realtime_max_length: Invalid Control Port Index ");
+		 return 0;
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_STRING || !plugin->plugin_caps->control_port_caps[i]->is_realtime_safe) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_string_port_realtime_max_length: Port is not a realtime string port ");
+		 return 0;
+	 }
+
+	 return plugin->plugin_caps->control_port_caps[i]->realtime_port_string_max_len+1;
+ }
+
+
+ void DSPlug_PluginInstance_get_control_port_data( DSPlug_PluginInstance *p_instance, int i , void ** d, int * l ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_data_port: Calling with NULL PluginInstance ");
+		 return ; /* return anything */
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_data_port: Invalid Control Port Index ");
+		 return ; /* return anything */
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->type!=DSPLUG_CONTROL_PORT_TYPE_DATA) {
+
+		 DSPlug_report_error("HOST: DSPlug_ControlPortCaps_get_control_data_port: Port is not of data type ");
+		 return ; /* return anything */
+
+	 }
+
+	 if (plugin->plugin_caps->control_port_caps[i]->get_callback_data) {
+
+		 plugin->plugin_caps->control_port_caps[i]->get_callback_data(*plugin_public,i,d,l);
+	 } else {
+
+		 DSPlug_report_error("API: DSPlug_ControlPortCaps_get_control_data_port: Control Port not configured, Bug? ");
+	 }
+
+
+ }
+
+
+ DSPlug_DataBuffer * DSPlug_PluginInstance_get_control_port_data_buffer( DSPlug_PluginInstance *p_instance, int i ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_ControlPortCapsPrivate *caps;
+	 void *data=NULL;
+	 int length=0;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_port_data_buffer: Calling with NULL PluginInstance ");
+		 return NULL;
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_port_data_buffer: Invalid Control Port Index ");
+		 return NULL;
+	 }
+
+	 caps=plugin->plugin_caps->control_port_caps[i];
+
+	 if (caps->type!=DSPLUG_CONTROL_PORT_TYPE_DATA) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_control_port_data_buffer: Port is not of data type ");
+		 return NULL;
+	 }
+
+	 if (caps->get_callback_data_buffer)
+		 return caps->get_callback_data_buffer(*plugin_public,i);
+
+	 if (!caps->get_callback_data) {
+
+		 DSPlug_report_error("API: DSPlug_PluginInstance_get_control_port_data_buffer: Control Port not configured, Bug? ");
+		 return NULL;
+	 }
+
+	 caps->get_callback_data(*plugin_public,i,&data,&length);
+
+	 return DSPlug_DataBuffer_create(data,length);
+ }
+
+
+ void DSPlug_PluginInstance_set_UI_changed_control_port_callback( DSPlug_PluginInstance *p_instance, int i , void (*c)(int, void *) , void * u) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_port_changed_callback: Calling with NULL PluginInstance ");
+		 return ; /* return anything */
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_control_port_changed_callback: Invalid Control Port Index ");
+		 return ; /* return anything */
+	 }
+
+	 plugin->control_ports[i].UI_changed_callback=c;
+	 plugin->control_ports[i].UI_changed_callback_userdata=u;
+
+ }
+
+ int DSPlug_PluginInstance_drain_UI_changes( DSPlug_PluginInstance *p_instance, int *p, int n ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 unsigned int summary,bits;
+	 int s,w,i,count=0;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_drain_UI_changes: Calling with NULL PluginInstance ");
+		 return 0;
+	 }
+
+	 if (!p || n<=0)
+		 return 0;
+
+	 for (s=0;s<plugin->UI_summary_words && count<n;s++) {
+
+		 if (!plugin->UI_summary[s])
+			 continue;
+
+		 /* Swap the words with zero, notifications from now on will be seen next time */
+		 for (summary=DSPLUG_ATOMIC_FETCH_AND(&plugin->UI_summary[s],0),w=s*32;summary;summary>>=1,w++) {
+
+			 if (!(summary&1))
+				 continue;
+
+			 if (count==n) {
+
+				 /* out of room, leave the rest for the next call */
+				 DSPLUG_ATOMIC_FETCH_OR(&plugin->UI_summary[s],summary<<(w%32));
+				 break;
+			 }
+
+			 bits=DSPLUG_ATOMIC_FETCH_AND(&plugin->UI_dirty[w],0);
+
+			 for (i=w*32;bits;bits>>=1,i++) {
+
+				 if (!(bits&1))
+					 continue;
+
+				 if (count==n) {
+
+					 DSPLUG_ATOMIC_FETCH_OR(&plugin->UI_dirty[w],bits<<(i%32));
+					 DSPLUG_ATOMIC_FETCH_OR(&plugin->UI_summary[s],1U<<(w%32));
+					 break;
+				 }
+
+				 p[count++]=i;
+			 }
+		 }
+	 }
+
+	 return count;
+ }
+
+ void DSPlug_PluginInstance_dispatch_UI_changes( DSPlug_PluginInstance *p_instance ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 int ports[DSPLUG_UI_CHANGES_DISPATCH_CHUNK];
+	 int i,n;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_dispatch_UI_changes: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 do {
+
+		 n=DSPlug_PluginInstance_drain_UI_changes(p_instance,ports,DSPLUG_UI_CHANGES_DISPATCH_CHUNK);
+
+		 for (i=0;i<n;i++) {
+
+			 if (plugin->control_ports[ports[i]].UI_changed_callback)
+				 plugin->control_ports[ports[i]].UI_changed_callback(ports[i],plugin->control_ports[ports[i]].UI_changed_callback_userdata);
+		 }
+
+	 } while (n==DSPLUG_UI_CHANGES_DISPATCH_CHUNK);
+ }
+
+
+
+ /****************************/
+
+ /* PROCESSING THE AUDIO */
+
+ /****************************/
+
+ /* Checks that the plugin can be processed, and reports why if it can't */
+ static DSPlug_Boolean DSPlug_PluginInstance_can_process( DSPlug_PluginPrivate *plugin ) {
+
+	 if (plugin->inside_process_callback_flag) {
+
+		 DSPlug_report_error("API: DSPlug_PluginInstance_process: Attempt to call process() when already processing! ");
+		 return DSPLUG_FALSE;
+	 }
+
+	 if (!plugin->plugin_caps->process_callback) {
+
+		 DSPlug_report_error("API: DSPlug_PluginInstance_process: Plugin lacks process() callback, bug? ");
+		 return DSPLUG_FALSE;
+	 }
+
+	 return DSPLUG_TRUE;
+ }
+
+ static void DSPlug_PluginInstance_push_audio_event( DSPlug_EventQueue *q, int frame, int type, double real, int integer ) {
+
+	 DSPlug_Event ev;
+
+	 memset(&ev,0,sizeof(DSPlug_Event));
+	 ev.frame=frame;
+	 ev.type=type;
+	 if (type==DSPLUG_AUDIO_EVENT_PLAY_STATE || type==DSPLUG_AUDIO_EVENT_LATENCY)
+		 ev.data.integers[0]=integer;
+	 else
+		 ev.data.real=real;
+
+	 DSPlug_EventQueue_push(q,&ev);
+ }
+
+ /* Write the input events that arrived since the previous cycle to the event recorder */
+ static void DSPlug_PluginInstance_record_events( DSPlug_PluginPrivate *plugin, int f ) {
+
+	 const DSPlug_Event *ev;
+	 DSPlug_EventPortPrivate *port;
+	 const void *payload;
+	 unsigned int pos,read_pos,write_pos;
+	 int i,size;
+
+	 if (!plugin->event_recorder)
+		 return;
+
+	 DSPlug_EventRecorder_begin_cycle(plugin->event_recorder,f);
+
+	 for (i=0;i<plugin->event_port_count;i++) {
+
+		 port=&plugin->event_ports[i];
+
+		 if (!port->queue || port->queue==port->generated_queue || plugin->plugin_caps->event_port_caps[i]->common.plug_type!=DSPLUG_PLUG_INPUT)
+			 continue;
+
+		 /* Events the plugin left in the queue were recorded already, start after them */
+		 read_pos=DSPlug_EventQueue_get_read_position(port->queue);
+		 write_pos=DSPlug_EventQueue_get_write_position(port->queue);
+
+		 if (port->recorded_queue!=port->queue || (write_pos-port->recorded_pos)>(write_pos-read_pos))
+			 port->recorded_pos=read_pos;
+
+		 for (pos=port->recorded_pos;pos!=write_pos;pos++) {
+
+			 ev=DSPlug_EventQueue_get_at_position(port->queue,pos,&payload,&size);
+			 if (!ev)
+				 break;
+
+			 DSPlug_EventRecorder_record_payload_event(plugin->event_recorder,i,ev,payload,size);
+		 }
+
+		 port->recorded_queue=port->queue;
+		 port->recorded_pos=pos;
+	 }
+ }
+
+ /* Amount of whole frames until the transport reaches a position d frames ahead, d must be positive */
+ static int DSPlug_frames_until( double d ) {
+
+	 int frames=(int)d;
+
+	 return (frames<d) ? frames+1 : frames;
+ }
+
+ /* Fill the transport queues of the AUDIO input ports for a cycle of f frames */
+ static void DSPlug_PluginInstance_send_transport_events( DSPlug_PluginPrivate *plugin, int f ) {
+
+	 DSPlug_TransportPrivate *transport=&plugin->transport;
+	 DSPlug_EventQueue *q;
+	 double pos;
+	 int i,frame,step;
+
+	 for (i=0;i<plugin->event_port_count;i++) {
+
+		 q=plugin->event_ports[i].generated_queue;
+		 if (!q || plugin->event_ports[i].queue!=q)
+			 continue; /* the host connected its own queue */
+
+		 /* we are the only producer, and the plugin isn't consuming now */
+		 DSPlug_EventQueue_flush(q);
+
+		 DSPlug_PluginInstance_push_audio_event(q,0,DSPLUG_AUDIO_EVENT_PLAY_STATE,0,transport->playing);
+		 DSPlug_PluginInstance_push_audio_event(q,0,DSPLUG_AUDIO_EVENT_POSITION,transport->position,0);
+		 DSPlug_PluginInstance_push_audio_event(q,0,DSPLUG_AUDIO_EVENT_LOOP_BEGIN,transport->loop_begin,0);
+		 DSPlug_PluginInstance_push_audio_event(q,0,DSPLUG_AUDIO_EVENT_LOOP_END,(transport->loop_end>transport->loop_begin)?transport->loop_end:transport->loop_begin,0);
+		 DSPlug_PluginInstance_push_audio_event(q,0,DSPLUG_AUDIO_EVENT_LATENCY,0,transport->upstream_latency);
+
+		 if (!transport->playing || transport->loop_end<=transport->loop_begin)
+			 continue;
+
+		 /* Jumps back to the loop beginning, if there are more than fit the queue drops them */
+		 for (frame=0,pos=transport->position;pos<transport->loop_end;) {
+
+			 step=DSPlug_frames_until(transport->loop_end-pos);
+			 frame+=step;
+			 if (frame>=f)
+				 break;
+
+			 pos=transport->loop_begin+(pos+step-transport->loop_end);
+			 DSPlug_PluginInstance_push_audio_event(q,frame,DSPLUG_AUDIO_EVENT_POSITION,pos,0);
+		 }
+	 }
+ }
+
+ /* Move the transport to the beginning of the next cycle, the same way the events above do */
+ static void DSPlug_PluginInstance_advance_transport( DSPlug_PluginPrivate *plugin, int f ) {
+
+	 DSPlug_TransportPrivate *transport=&plugin->transport;
+	 double pos=transport->position;
+	 int step;
+
+	 if (!transport->playing)
+		 return;
+
+	 if (transport->loop_end>transport->loop_begin) {
+
+		 while (pos<transport->loop_end && (step=DSPlug_frames_until(transport->loop_end-pos))<=f) {
+
+			 pos=transport->loop_begin+(pos+step-transport->loop_end);
+			 f-=step;
+		 }
+	 }
+
+	 transport->position=pos+f;
+ }
+
+ /* Apply the control values posted to the mailbox since the last cycle */
+ static void DSPlug_PluginInstance_drain_control_mailbox( DSPlug_Plugin *plugin_public, DSPlug_PluginPrivate *plugin ) {
+
+	 unsigned int summary,bits;
+	 int s,w,i,n=0;
+
+	 for (s=0;s<plugin->mailbox_summary_words;s++) {
+
+		 if (!plugin->mailbox_summary[s])
+			 continue;
+
+		 /* Swap the words with zero, values posted from now on will be seen next cycle */
+		 for (summary=DSPLUG_ATOMIC_FETCH_AND(&plugin->mailbox_summary[s],0),w=s*32;summary;summary>>=1,w++) {
+
+			 if (!(summary&1))
+				 continue;
+
+			 bits=DSPLUG_ATOMIC_FETCH_AND(&plugin->mailbox_dirty[w],0);
+			 DSPLUG_MEMORY_BARRIER(); /* values are read after the bits */
+
+			 for (i=w*32;bits;bits>>=1,i++) {
+
+				 if (!(bits&1))
+					 continue;
+
+				 plugin->mailbox_batch_ports[n]=i;
+				 plugin->mailbox_batch_values[n]=plugin->mailbox_values[i];
+				 n++;
+			 }
+		 }
+	 }
+
+	 /* ports were validated when posted */
+	 if (n)
+		 DSPlug_PluginInstance_dispatch_numerical_batch(plugin_public,plugin,plugin->mailbox_batch_ports,plugin->mailbox_batch_values,n);
+ }
+
+ /* Take the automation published by the host, at the beginning of a cycle */
+ static void DSPlug_PluginInstance_swap_automation( DSPlug_PluginPrivate *plugin ) {
+
+	 DSPlug_AutomationPrivate *automation;
+	 int i,j;
+
+	 /* the replaced lanes can't be freed here, wait until the host frees the last ones */
+	 if (!plugin->automation_pending || plugin->automation_retired)
+		 return;
+
+	 automation=(DSPlug_AutomationPrivate*)DSPlug_atomic_exchange_pointer(&plugin->automation_pending,NULL);
+
+	 if (!automation)
+		 return;
+
+	 if (plugin->automation) {
+
+		 /* don't leave the plugin reading a rendered buffer that is going away */
+		 for (i=0;i<plugin->automation->lane_count;i++) {
+
+			 j=plugin->automation->ports[i];
+			 if (plugin->automation->lanes[i].render_buffer)
+				 plugin->control_ports[j].modulation_buffer_ptr=plugin->control_ports[j].modulation_buffer;
+		 }
+
+		 DSPlug_atomic_exchange_pointer(&plugin->automation_retired,plugin->automation); /* published, the host may free it any time now */
+	 }
+
+	 plugin->automation=automation;
+ }
+
+ /* Everything the library does for the instance before processing a cycle */
+ static void DSPlug_PluginInstance_begin_cycle( DSPlug_Plugin *plugin_public, DSPlug_PluginPrivate *plugin, int f ) {
+
+	 if (plugin->mailbox_values)
+		 DSPlug_PluginInstance_drain_control_mailbox(plugin_public,plugin);
+
+	 if (plugin->async_data_port_count)
+		 DSPlug_PluginInstance_swap_async_data(plugin);
+
+	 if (plugin->automation_pending)
+		 DSPlug_PluginInstance_swap_automation(plugin);
+
+	 if (plugin->managed_string_port_count)
+		 DSPlug_PluginInstance_swap_managed_strings(plugin);
+
+	 DSPlug_PluginInstance_send_transport_events(plugin,f);
+	 DSPlug_PluginInstance_record_events(plugin,f);
+ }
+
+ /* And after */
+ static void DSPlug_PluginInstance_end_cycle( DSPlug_PluginPrivate *plugin, int f ) {
+
+	 DSPlug_PluginInstance_advance_transport(plugin,f);
+ }
+
+ /* Evaluate the automation lanes at the beginning of the frames [from,from+f) of the block */
+ static void DSPlug_PluginInstance_run_automation( DSPlug_Plugin *plugin_public, DSPlug_PluginPrivate *plugin, int from, int f ) {
+
+	 DSPlug_AutomationPrivate *automation=plugin->automation;
+	 DSPlug_AutomationLanePrivate *lane;
+	 double position=plugin->transport.position+from;
+	 int i,j,n=0;
+
+	 DSPlug_Automation_evaluate(automation,position);
+
+	 for (i=0;i<automation->lane_count;i++) {
+
+		 j=automation->ports[i];
+		 lane=&automation->lanes[i];
+
+		 /* Ports that read modulation get every frame */
+		 if (lane->render_buffer) {
+
+			 if (f>0 && f<=DSPLUG_AUTOMATION_MAX_RENDER_FRAMES) {
+
+				 plugin->control_ports[j].modulation_buffer_ptr=DSPlug_Automation_render(automation,i,position,f);
+				 continue;
+			 }
+
+			 plugin->control_ports[j].modulation_buffer_ptr=plugin->control_ports[j].modulation_buffer ? plugin->control_ports[j].modulation_buffer+from : NULL;
+		 }
+
+		 if (lane->sent_valid && lane->sent==automation->values[i])
+			 continue;
+
+		 lane->sent=automation->values[i];
+		 lane->sent_valid=DSPLUG_TRUE;
+		 automation->batch_ports[n]=j;
+		 automation->batch_values[n]=automation->values[i];
+		 n++;
+	 }
+
+	 if (n)
+		 DSPlug_PluginInstance_dispatch_numerical_batch(plugin_public,plugin,automation->batch_ports,automation->batch_values,n);
+ }
+
+ /* Call process() for the frames [from,from+f) of the block, the audio buffers are offset so the plugin sees them as a block of its own */
+ static void DSPlug_PluginInstance_process_range( DSPlug_Plugin *plugin_public, DSPlug_PluginPrivate *plugin, int from, int f ) {
+
+	 int i,j,k,n=0;
+	 const float *b;
+	 float sum;
+
+	 /* Point the modulation buffers at this block, decimate those the plugin doesn't read */
+	 for (i=0;i<plugin->modulated_control_port_count;i++) {
+
+		 j=plugin->modulated_control_ports[i];
+		 b=plugin->control_ports[j].modulation_buffer+from;
+
+		 if (plugin->plugin_caps->control_port_caps[j]->modulation_input) {
+
+			 plugin->control_ports[j].modulation_buffer_ptr=b;
+			 continue;
+		 }
+
+		 if (f<=0)
+			 continue;
+
+		 sum=0;
+		 for (k=0;k<f;k++)
+			 sum+=b[k];
+		 sum/=f;
+		 sum=(sum<0) ? 0 : ((sum>1) ? 1 : sum);
+
+		 /* the smoother keeps the last value set, a steady buffer sets nothing (nor floods the change log) */
+		 if (plugin->control_ports[j].smoother.primed && plugin->control_ports[j].smoother.target==sum)
+			 continue;
+
+		 plugin->modulation_batch_ports[n]=j;
+		 plugin->modulation_batch_values[n]=sum;
+		 n++;
+	 }
+
+	 if (n)
+		 DSPlug_PluginInstance_dispatch_numerical_batch(plugin_public,plugin,plugin->modulation_batch_ports,plugin->modulation_batch_values,n);
+
+	 /* Automation comes last, so it overrides modulation */
+	 if (plugin->automation && plugin->automation->lane_count)
+		 DSPlug_PluginInstance_run_automation(plugin_public,plugin,from,f);
+
+	 if (from) {
+
+		 for (i=0;i<plugin->audio_port_count;i++) {
+
+			 for (j=0;j<plugin->audio_ports[i].channel_count;j++)
+				 if (plugin->audio_ports[i].channel_buffer_ptr[j])
+					 plugin->audio_ports[i].channel_buffer_ptr[j]+=from;
+		 }
+	 }
+
+	 plugin->plugin_caps->process_callback(plugin_public,f);
+
+	 /* Move the ramps to the beginning of the next block */
+	 for (i=0;i<plugin->smoothed_control_port_count;i++) {
+
+		 j=plugin->smoothed_control_ports[i];
+		 DSPlug_Smoother_advance(&plugin->control_ports[j].smoother,plugin->plugin_caps->control_port_caps[j],f);
+	 }
+
+	 if (from) {
+
+		 for (i=0;i<plugin->audio_port_count;i++) {
+
+			 for (j=0;j<plugin->audio_ports[i].channel_count;j++)
+				 if (plugin->audio_ports[i].channel_buffer_ptr[j])
+					 plugin->audio_ports[i].channel_buffer_ptr[j]-=from;
+		 }
+	 }
+ }
+
+ void DSPlug_PluginInstance_process( DSPlug_PluginInstance *p_instance, int f ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_process: Calling with NULL PluginInstance ");
+		 return ; /* return anything */
+	 }
+
+	 if (!DSPlug_PluginInstance_can_process(plugin))
+		 return;
+
+	 DSPlug_PluginInstance_begin_cycle(plugin_public,plugin,f);
+
+	 plugin->inside_process_callback_flag=DSPLUG_TRUE;
+	 DSPlug_PluginInstance_process_range(plugin_public,plugin,0,f);
+	 plugin->inside_process_callback_flag=DSPLUG_FALSE;
+
+	 DSPlug_PluginInstance_end_cycle(plugin,f);
+ }
+
+ /* AUTOMATION */
+
+ /* Publish new lanes for the process thread, if the last ones weren't taken yet, nobody will take them now */
+ static void DSPlug_PluginInstance_publish_automation( DSPlug_PluginInstance *p_instance, DSPlug_PluginPrivate *plugin, DSPlug_AutomationPrivate *automation ) {
+
+	 void *replaced;
+
+	 plugin->automation_latest=automation;
+	 replaced=DSPlug_atomic_exchange_pointer(&plugin->automation_pending,automation);
+
+	 if (replaced)
+		 DSPlug_Automation_destroy((DSPlug_AutomationPrivate*)replaced);
+
+	 DSPlug_PluginInstance_collect_retired_data(p_instance);
+ }
+
+ DSPlug_Boolean DSPlug_PluginInstance_set_automation_lane( DSPlug_PluginInstance *p_instance, int i, const DSPlug_AutomationPoint *p, int n ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 DSPlug_ControlPortCapsPrivate *caps;
+	 DSPlug_AutomationPrivate *automation;
+	 int j;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_automation_lane: Calling with NULL PluginInstance ");
+		 return DSPLUG_FALSE;
+	 }
+
+	 if (i<0 || i>=plugin->control_port_count) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_automation_lane: Invalid Control Port Index ");
+		 return DSPLUG_FALSE;
+	 }
+
+	 caps=plugin->plugin_caps->control_port_caps[i];
+
+	 if (caps->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL || caps->common.plug_type!=DSPLUG_PLUG_INPUT || !caps->set_callback_numerical) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_automation_lane: Only numerical input ports can be automated ");
+		 return DSPLUG_FALSE;
+	 }
+
+	 if (n<0 || (n>0 && !p)) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_automation_lane: Invalid breakpoints ");
+		 return DSPLUG_FALSE;
+	 }
+
+	 for (j=1;j<n;j++) {
+
+		 if (p[j].frame<p[j-1].frame) {
+
+			 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_automation_lane: Breakpoints are not sorted by frame ");
+			 return DSPLUG_FALSE;
+		 }
+	 }
+
+	 if (!plugin->automation_latest) {
+
+		 if (n==0)
+			 return DSPLUG_TRUE;
+
+		 automation=DSPlug_Automation_create(plugin->control_port_count);
+	 } else {
+
+		 /* the process thread may be playing the latest lanes, they are only read to copy them */
+		 automation=DSPlug_Automation_copy(plugin->automation_latest);
+	 }
+
+	 DSPlug_Automation_set_lane(automation,i,p,n,caps->modulation_input ? DSPLUG_AUTOMATION_MAX_RENDER_FRAMES : 0);
+	 DSPlug_PluginInstance_publish_automation(p_instance,plugin,automation);
+
+	 return DSPLUG_TRUE;
+ }
+
+ void DSPlug_PluginInstance_clear_automation( DSPlug_PluginInstance *p_instance ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_clear_automation: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 if (!plugin->automation_latest || plugin->automation_latest->lane_count==0)
+		 return;
+
+	 DSPlug_PluginInstance_publish_automation(p_instance,plugin,DSPlug_Automation_create(plugin->control_port_count));
+ }
+
+ /* SAMPLE ACCURATE AUTOMATION */
+
+ void DSPlug_PluginInstance_set_sub_block_splitting( DSPlug_PluginInstance *p_instance, DSPlug_Boolean e, int m ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_sub_block_splitting: Calling with NULL PluginInstance ");
+		 return ; /* return anything */
+	 }
+
+	 if (m<1) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_sub_block_splitting: Minimum sub-block size must be 1 or more ");
+		 return ;
+	 }
+
+	 plugin->sub_block_splitting=e;
+	 plugin->sub_block_min_frames=m;
+ }
+
+ void DSPlug_PluginInstance_process_control_changes( DSPlug_PluginInstance *p_instance, int f, const DSPlug_ControlChange *c, int n ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 int from=0;
+	 int to;
+	 int change=0;
+	 int min_frames;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_process_control_changes: Calling with NULL PluginInstance ");
+		 return ; /* return anything */
+	 }
+
+	 if (!DSPlug_PluginInstance_can_process(plugin))
+		 return;
+
+	 /* Without splitting, everything happens at the beginning of the block */
+	 min_frames = plugin->sub_block_splitting ? plugin->sub_block_min_frames : f;
+
+	 DSPlug_PluginInstance_begin_cycle(plugin_public,plugin,f);
+
+	 plugin->inside_process_callback_flag=DSPLUG_TRUE;
+
+	 while (from<f) {
+
+		 /* Changes that would make a too small sub-block are applied now */
+		 while (change<n && c[change].frame<from+min_frames) {
+
+			 DSPlug_PluginInstance_set_control_numerical_port(p_instance,c[change].port,c[change].value);
+			 change++;
+		 }
+
+		 to=f;
+
+		 /* Split at the next change, unless the tail would be too small */
+		 if (change<n && c[change].frame<f && (f-c[change].frame)>=min_frames)
+			 to=c[change].frame;
+
+		 DSPlug_PluginInstance_process_range(plugin_public,plugin,from,to-from);
+		 from=to;
+	 }
+
+	 plugin->inside_process_callback_flag=DSPLUG_FALSE;
+
+	 DSPlug_PluginInstance_end_cycle(plugin,f);
+
+	 /* What is left was too close to the end of the block, apply it for the next one */
+	 while (change<n) {
+
+		 DSPlug_PluginInstance_set_control_numerical_port(p_instance,c[change].port,c[change].value);
+		 change++;
+	 }
+ }
+
+
+
+
+
+ /* TRANSPORT */
+
+ void DSPlug_PluginInstance_set_transport_position( DSPlug_PluginInstance *p_instance, double p ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_transport_position: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 plugin->transport.position=p;
+ }
+
+ double DSPlug_PluginInstance_get_transport_position( DSPlug_PluginInstance *p_instance ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_get_transport_position: Calling with NULL PluginInstance ");
+		 return 0; /* return anything */
+	 }
+
+	 return plugin->transport.position;
+ }
+
+ void DSPlug_PluginInstance_set_transport_playing( DSPlug_PluginInstance *p_instance, DSPlug_Boolean p ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_transport_playing: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 plugin->transport.playing=p;
+ }
+
+ void DSPlug_PluginInstance_set_transport_loop( DSPlug_PluginInstance *p_instance, double b, double e ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_transport_loop: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 plugin->transport.loop_begin=b;
+	 plugin->transport.loop_end=e;
+ }
+
+ void DSPlug_PluginInstance_set_upstream_latency( DSPlug_PluginInstance *p_instance, int l ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_upstream_latency: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 plugin->transport.upstream_latency=l;
+ }
+
+
+ /* EVENT RECORDING */
+
+ void DSPlug_PluginInstance_set_event_recorder( DSPlug_PluginInstance *p_instance, DSPlug_EventRecorder *r ) {
+
+	 DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	 int i;
+
+	 if (plugin_public==NULL || plugin==NULL) {
+
+		 DSPlug_report_error("HOST: DSPlug_PluginInstance_set_event_recorder: Calling with NULL PluginInstance ");
+		 return ;
+	 }
+
+	 /* a new recording starts with whatever is pending */
+	 for (i=0;i<plugin->event_port_count;i++)
+		 plugin->event_ports[i].recorded_queue=NULL;
+
+	 plugin->event_recorder=r;
+ }
 
 
  /* RESETTING THE STATE */
@@ -0,0 +1,176 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_event.h"
+#include "dsplug_error_report.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/****************************/
+
+/* MIDI EVENT BLOCK */
+
+/****************************/
+
+DSPlug_MidiEventBlock * DSPlug_MidiEventBlock_create( int c ) {
+
+	DSPlug_MidiEventBlock *block;
+
+	if (c<=0 || c>DSPLUG_EVENT_QUEUE_MAX_CAPACITY) {
+
+		DSPlug_report_error("EVENT: DSPlug_MidiEventBlock_create: Invalid block capacity");
+		return NULL;
+	}
+
+	block = (DSPlug_MidiEventBlock*)malloc(sizeof(DSPlug_MidiEventBlock));
+	memset(block,0,sizeof(DSPlug_MidiEventBlock));
+
+	block->capacity=c;
+	block->frames=(int*)malloc(sizeof(int)*c);
+	block->status=(unsigned char*)malloc(c);
+	block->data1=(unsigned char*)malloc(c);
+	block->data2=(unsigned char*)malloc(c);
+
+	return block;
+}
+
+void DSPlug_MidiEventBlock_destroy( DSPlug_MidiEventBlock *p_block ) {
+
+	if (!p_block) {
+
+		DSPlug_report_error("EVENT: DSPlug_MidiEventBlock_destroy: Invalid MidiEventBlock object (NULL)");
+		return;
+	}
+
+	free(p_block->frames);
+	free(p_block->status);
+	free(p_block->data1);
+	free(p_block->data2);
+	free(p_block);
+}
+
+void DSPlug_MidiEventBlock_clear( DSPlug_MidiEventBlock *p_block ) {
+
+	p_block->count=0;
+}
+
+DSPlug_Boolean DSPlug_MidiEventBlock_add( DSPlug_MidiEventBlock *p_block, int f, unsigned char s, unsigned char d1, unsigned char d2 ) {
+
+	int idx=p_block->count;
+
+	if (idx>=p_block->capacity)
+		return DSPLUG_FALSE;
+
+	p_block->frames[idx]=f;
+	p_block->status[idx]=s;
+	p_block->data1[idx]=d1;
+	p_block->data2[idx]=d2;
+	p_block->count++;
+
+	return DSPLUG_TRUE;
+}
+
+int DSPlug_MidiEventBlock_encode_queue( DSPlug_MidiEventBlock *p_block, DSPlug_EventQueue *q ) {
+
+	const DSPlug_Event *ev;
+	DSPlug_Event discard;
+	int encoded=0;
+
+	while (p_block->count<p_block->capacity) {
+
+		ev=DSPlug_EventQueue_peek(q);
+		if (!ev || ev->type!=DSPLUG_MIDI_EVENT_MESSAGE)
+			break;
+
+		DSPlug_MidiEventBlock_add(p_block,ev->frame,ev->data.bytes[0],ev->data.bytes[1],ev->data.bytes[2]);
+		DSPlug_EventQueue_pop(q,&discard);
+		encoded++;
+	}
+
+	return encoded;
+}
+
+int DSPlug_MidiEventBlock_decode_queue( DSPlug_MidiEventBlock *p_block, DSPlug_EventQueue *q ) {
+
+	DSPlug_Event ev;
+	int i;
+
+	memset(&ev,0,sizeof(DSPlug_Event));
+	ev.type=DSPLUG_MIDI_EVENT_MESSAGE;
+
+	for (i=0;i<p_block->count;i++) {
+
+		ev.frame=p_block->frames[i];
+		ev.data.bytes[0]=p_block->status[i];
+		ev.data.bytes[1]=p_block->data1[i];
+		ev.data.bytes[2]=p_block->data2[i];
+
+		if (!DSPlug_EventQueue_push(q,&ev))
+			break; /* queue is full */
+	}
+
+	return i;
+}
+
+int DSPlug_MidiEventBlock_find_status( DSPlug_MidiEventBlock *p_block, int from, unsigned char m, unsigned char v ) {
+
+	/* byte replicating constants, 0x0101.. and 0x8080.. for any word size */
+	unsigned long ones = ((unsigned long)-1)/0xFF;
+	unsigned long highs = ones*0x80;
+	unsigned long mask_word = ones*m;
+	unsigned long value_word = ones*v;
+	unsigned long word,diff;
+	int i=(from<0)?0:from;
+
+	if ((v&m)!=v)
+		return -1; /* can't ever match */
+
+	/* Compare a whole word of status bytes at a time, matching bytes become zero */
+	while ( (i+(int)sizeof(unsigned long)) <= p_block->count ) {
+
+		memcpy(&word,&p_block->status[i],sizeof(unsigned long));
+		diff=(word&mask_word)^value_word;
+
+		if ( (diff-ones) & ~diff & highs )
+			break; /* there is a match in this word, the loop below finds it */
+
+		i+=sizeof(unsigned long);
+	}
+
+	for (;i<p_block->count;i++) {
+
+		if ((p_block->status[i]&m)==v)
+			return i;
+	}
+
+	return -1;
+}
+
+int DSPlug_MidiEventBlock_find_controller( DSPlug_MidiEventBlock *p_block, int from, unsigned char cc ) {
+
+	int i=from;
+
+	while ( (i=DSPlug_MidiEventBlock_find_status(p_block,i,DSPLUG_MIDI_STATUS_TYPE_MASK,DSPLUG_MIDI_STATUS_CONTROLLER)) >= 0 ) {
+
+		if (p_block->data1[i]==cc)
+			return i;
+		i++;
+	}
+
+	return -1;
+}
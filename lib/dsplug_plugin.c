@@ -17,6 +17,8 @@
 #include "dsplug_plugin.h"
 #include "dsplug_private.h"
 #include "dsplug_helpers.h"
+#include "dsplug_smoother.h"
+#include "dsplug_atomic.h"
 #include "dsplug_error_report.h"
 
 #include <stdlib.h>
@@ -88,7 +90,13 @@ DSPlug_Boolean DSPlug_LibraryCreation_add_plugin( DSPlug_LibraryCreation p_lib_c
 		return DSPLUG_FALSE;
 	}
 
-	library->plugin_caps_array=realloc( library->plugin_caps_array, library->plugin_count*sizeof(DSPlug_PluginCapsPrivate) );
+	DSPlug_build_port_index(&plugin_caps->port_index[DSPLUG_PORT_AUDIO],(DSPlug_CommonPortCapsPrivate **)plugin_caps->audio_port_caps,plugin_caps->audio_port_count);
+	DSPlug_build_port_index(&plugin_caps->port_index[DSPLUG_PORT_EVENT],(DSPlug_CommonPortCapsPrivate **)plugin_caps->event_port_caps,plugin_caps->event_port_count);
+	DSPlug_build_port_index(&plugin_caps->port_index[DSPLUG_PORT_CONTROL],(DSPlug_CommonPortCapsPrivate **)plugin_caps->control_port_caps,plugin_caps->control_port_count);
+	DSPlug_build_musical_part_index(plugin_caps);
+
+	library->plugin_count++;
+	library->plugin_caps_array=realloc( library->plugin_caps_array, library->plugin_count*sizeof(DSPlug_PluginCapsPrivate*) );
 	library->plugin_caps_array[library->plugin_count-1]=plugin_caps;
 
 	return DSPLUG_TRUE;
@@ -313,6 +321,7 @@ void DSPlug_PluginCreation_add_audio_port( DSPlug_PluginCreation *p_plugin_creat
 	plugin_caps->audio_port_caps=(DSPlug_AudioPortCapsPrivate**)realloc(plugin_caps->audio_port_caps,sizeof(DSPlug_AudioPortCapsPrivate*)*plugin_caps->audio_port_count);
 
 	plugin_caps->audio_port_caps[plugin_caps->audio_port_count-1]=(DSPlug_AudioPortCapsPrivate*)malloc(sizeof(DSPlug_AudioPortCapsPrivate));
+	memset(plugin_caps->audio_port_caps[plugin_caps->audio_port_count-1],0,sizeof(DSPlug_AudioPortCapsPrivate));
 	DSPlug_CommonPortCapsPrivate *cpc=&plugin_caps->audio_port_caps[plugin_caps->audio_port_count-1]->common;
 	DSPlug_copy_to_newstring(&cpc->caption,label);
 	DSPlug_copy_to_newstring(&cpc->name,name);
@@ -324,7 +333,7 @@ void DSPlug_PluginCreation_add_audio_port( DSPlug_PluginCreation *p_plugin_creat
 
 }
 
-void DSPlug_PluginCreation_add_event_port( DSPlug_PluginCreation *p_plugin_creation , DSPlug_PlugType plug, const char *label, const char *name , const char *path, DSPlug_EventType evt ) {
+void DSPlug_PluginCreation_add_event_port( DSPlug_PluginCreation *p_plugin_creation , DSPlug_PlugType plug, const char *label, const char *name , const char *path, DSPlug_EventType evt, int c ) {
 
 	DSPlug_PluginCapsPrivate *plugin_caps = (DSPlug_PluginCapsPrivate *)p_plugin_creation->_private;
 
@@ -344,6 +353,7 @@ void DSPlug_PluginCreation_add_event_port( DSPlug_PluginCreation *p_plugin_creat
 	plugin_caps->event_port_caps=(DSPlug_EventPortCapsPrivate**)realloc(plugin_caps->event_port_caps,sizeof(DSPlug_EventPortCapsPrivate*)*plugin_caps->event_port_count);
 
 	plugin_caps->event_port_caps[plugin_caps->event_port_count-1]=(DSPlug_EventPortCapsPrivate*)malloc(sizeof(DSPlug_EventPortCapsPrivate));
+	memset(plugin_caps->event_port_caps[plugin_caps->event_port_count-1],0,sizeof(DSPlug_EventPortCapsPrivate));
 	DSPlug_CommonPortCapsPrivate *cpc=&plugin_caps->event_port_caps[plugin_caps->event_port_count-1]->common;
 	DSPlug_copy_to_newstring(&cpc->caption,label);
 	DSPlug_copy_to_newstring(&cpc->name,name);
@@ -351,6 +361,11 @@ void DSPlug_PluginCreation_add_event_port( DSPlug_PluginCreation *p_plugin_creat
 	cpc->plug_type=plug;
 
 	plugin_caps->event_port_caps[plugin_caps->event_port_count-1]->event_type=evt;
+	plugin_caps->event_port_caps[plugin_caps->event_port_count-1]->capacity_hint=(c>0)?c:0;
+
+	/* a bigger hint would make hosts fail creating the queue */
+	if (c>DSPLUG_EVENT_QUEUE_MAX_CAPACITY)
+		plugin_caps->event_port_caps[plugin_caps->event_port_count-1]->capacity_hint=DSPLUG_EVENT_QUEUE_MAX_CAPACITY;
 
 }
 
@@ -399,13 +414,15 @@ void DSPlug_PluginCreation_add_control_port( DSPlug_PluginCreation *p_plugin_cre
 }
 
 /*** HELPER ****/
-static void DSPlug_instance_control_port_creation(DSPlug_ControlPortCreation *ctpc,DSPlug_ControlPortCapsPrivate *cpc ) {
+static DSPlug_ControlPortCreation * DSPlug_instance_control_port_creation(DSPlug_ControlPortCapsPrivate **cpc ) {
 
-	ctpc =(DSPlug_ControlPortCreation*)malloc(sizeof(DSPlug_ControlPortCreation));
-	cpc = (DSPlug_ControlPortCapsPrivate*)malloc(sizeof(DSPlug_ControlPortCapsPrivate*));
-	ctpc->_private=cpc;
+	DSPlug_ControlPortCreation *ctpc =(DSPlug_ControlPortCreation*)malloc(sizeof(DSPlug_ControlPortCreation));
+	*cpc = (DSPlug_ControlPortCapsPrivate*)malloc(sizeof(DSPlug_ControlPortCapsPrivate));
+	ctpc->_private=*cpc;
 
-	memset(cpc,0,sizeof(DSPlug_ControlPortCapsPrivate));
+	memset(*cpc,0,sizeof(DSPlug_ControlPortCapsPrivate));
+
+	return ctpc;
 }
 
 DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_float( void (*set_cbk)(DSPlug_Plugin , int, float) ,  float (*get_cbk)(DSPlug_Plugin , int) , void (*disp_func)(float, char *)) {
@@ -420,7 +437,7 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_float(
 	}
 
 
-	DSPlug_instance_control_port_creation( control_port_creation, control_port_caps );
+	control_port_creation = DSPlug_instance_control_port_creation( &control_port_caps );
 
 	control_port_caps->type=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL;
 	control_port_caps->numerical_hint=DSPLUG_CONTROL_PORT_HINT_TYPE_FLOAT;
@@ -452,11 +469,12 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_integer
 		return NULL;
 	}
 
-	DSPlug_instance_control_port_creation( control_port_creation, control_port_caps );
+	control_port_creation = DSPlug_instance_control_port_creation( &control_port_caps );
 
 	control_port_caps->type=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL;
 	control_port_caps->numerical_hint=DSPLUG_CONTROL_PORT_HINT_TYPE_INTEGER;
 	control_port_caps->integer_is_enum=is_enum;
+	control_port_caps->integer_steps=steps;
 
 	control_port_caps->set_callback_numerical=set_cbk;
 	control_port_caps->get_callback_numerical=get_cbk;
@@ -478,7 +496,7 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		return NULL;
 	}
 
-	DSPlug_instance_control_port_creation( control_port_creation, control_port_caps );
+	control_port_creation = DSPlug_instance_control_port_creation( &control_port_caps );
 
 	control_port_caps->type=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL;
 	control_port_caps->numerical_hint=DSPLUG_CONTROL_PORT_HINT_TYPE_BOOL;
@@ -504,7 +522,7 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		 return NULL;
 	 }
 
-	 DSPlug_instance_control_port_creation( control_port_creation, control_port_caps );
+	 control_port_creation = DSPlug_instance_control_port_creation( &control_port_caps );
 
 	 control_port_caps->type=DSPLUG_CONTROL_PORT_TYPE_STRING;
 
@@ -529,12 +547,13 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		 return NULL;
 	 }
 
-	 DSPlug_instance_control_port_creation( control_port_creation, control_port_caps );
+	 control_port_creation = DSPlug_instance_control_port_creation( &control_port_caps );
 
 	 control_port_caps->type=DSPLUG_CONTROL_PORT_TYPE_STRING;
 
 	 control_port_caps->set_callback_string=set_cbk;
 	 control_port_caps->get_callback_string_realtime=get_cbk;
+	 control_port_caps->realtime_port_string_max_len=(maxlen>0) ? maxlen : DSPLUG_STRING_PARAM_MAX_LEN;
 
 	 control_port_caps->is_realtime_safe=DSPLUG_TRUE;
 
@@ -542,6 +561,50 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
  }
 
 
+ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_string_managed( int maxlen ) {
+
+	 DSPlug_ControlPortCreation *control_port_creation;
+	 DSPlug_ControlPortCapsPrivate *control_port_caps;
+
+	 control_port_creation = DSPlug_instance_control_port_creation( &control_port_caps );
+
+	 control_port_caps->type=DSPLUG_CONTROL_PORT_TYPE_STRING;
+
+	 control_port_caps->managed_string=DSPLUG_TRUE;
+	 control_port_caps->realtime_port_string_max_len=(maxlen>0) ? maxlen : DSPLUG_STRING_PARAM_MAX_LEN;
+
+	 control_port_caps->is_realtime_safe=DSPLUG_TRUE;
+
+	 return control_port_creation;
+ }
+
+ int DSPlug_ControlPortCreation_add_string_option(DSPlug_ControlPortCreation *p_port, const char *s) {
+
+	 DSPlug_ControlPortCapsPrivate *control_port_caps = (DSPlug_ControlPortCapsPrivate *)p_port->_private;
+
+
+	 if (!p_port || !control_port_caps) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_add_string_option: Invalid ControlPortCreation object (NULL)");
+		 return -1;
+	 }
+
+	 if (!control_port_caps->managed_string) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_add_string_option: Only managed string ports have options");
+		 return -1;
+	 }
+
+	 if (!s || (int)strlen(s)>control_port_caps->realtime_port_string_max_len) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_add_string_option: NULL string, or longer than the port max length");
+		 return -1;
+	 }
+
+	 return DSPlug_add_string_option(control_port_caps,s);
+ }
+
+
  DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_data( void (*set_cbk)(DSPlug_Plugin , int, const void *, int ) , void (*get_cbk)(DSPlug_Plugin , int, void **, int* ) ) {
 
 
@@ -554,7 +617,7 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		 return NULL;
 	 }
 
-	 DSPlug_instance_control_port_creation( control_port_creation, control_port_caps );
+	 control_port_creation = DSPlug_instance_control_port_creation( &control_port_caps );
 
 	 control_port_caps->type=DSPLUG_CONTROL_PORT_TYPE_DATA;
 
@@ -607,6 +670,104 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 
  }
 
+ void DSPlug_ControlPortCreation_set_smoothing(DSPlug_ControlPortCreation *p_port, DSPlug_SmoothingMode m, float t) {
+
+	 DSPlug_ControlPortCapsPrivate *control_port_caps = (DSPlug_ControlPortCapsPrivate *)p_port->_private;
+
+
+	 if (!p_port || !control_port_caps) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_smoothing: Invalid ControlPortCreation object (NULL)");
+		 return;
+	 }
+
+	 if (control_port_caps->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_smoothing: Only numerical ports can be smoothed");
+		 return;
+	 }
+
+	 if (m<DSPLUG_SMOOTHING_NONE || m>DSPLUG_SMOOTHING_FIXED_TIME || t<0) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_smoothing: Invalid smoothing mode or time");
+		 return;
+	 }
+
+	 control_port_caps->smoothing_mode=m;
+	 control_port_caps->smoothing_time=t;
+
+ }
+
+ void DSPlug_ControlPortCreation_set_modulation_input(DSPlug_ControlPortCreation *p_port, DSPlug_Boolean e) {
+
+	 DSPlug_ControlPortCapsPrivate *control_port_caps = (DSPlug_ControlPortCapsPrivate *)p_port->_private;
+
+
+	 if (!p_port || !control_port_caps) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_modulation_input: Invalid ControlPortCreation object (NULL)");
+		 return;
+	 }
+
+	 if (control_port_caps->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_modulation_input: Only numerical ports can be modulated");
+		 return;
+	 }
+
+	 control_port_caps->modulation_input=e;
+
+ }
+
+ void DSPlug_ControlPortCreation_set_data_buffer_callback(DSPlug_ControlPortCreation *p_port, DSPlug_DataBuffer * (*c)(DSPlug_Plugin , int)) {
+
+	 DSPlug_ControlPortCapsPrivate *control_port_caps = (DSPlug_ControlPortCapsPrivate *)p_port->_private;
+
+
+	 if (!p_port || !control_port_caps) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_data_buffer_callback: Invalid ControlPortCreation object (NULL)");
+		 return;
+	 }
+
+	 if (control_port_caps->type!=DSPLUG_CONTROL_PORT_TYPE_DATA) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_data_buffer_callback: Only data ports can provide data buffers");
+		 return;
+	 }
+
+	 control_port_caps->get_callback_data_buffer=c;
+
+ }
+
+ void DSPlug_ControlPortCreation_set_data_async(DSPlug_ControlPortCreation *p_port, void * (*prepare_cbk)(DSPlug_Plugin , int, const void *, int), void (*release_cbk)(DSPlug_Plugin , int, void *)) {
+
+	 DSPlug_ControlPortCapsPrivate *control_port_caps = (DSPlug_ControlPortCapsPrivate *)p_port->_private;
+
+
+	 if (!p_port || !control_port_caps) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_data_async: Invalid ControlPortCreation object (NULL)");
+		 return;
+	 }
+
+	 if (control_port_caps->type!=DSPLUG_CONTROL_PORT_TYPE_DATA) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_data_async: Only data ports can be asynchronous");
+		 return;
+	 }
+
+	 if (!prepare_cbk || !release_cbk) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_ControlPortCreation_set_data_async: NULL prepare/release callbacks provided");
+		 return;
+	 }
+
+	 control_port_caps->prepare_callback_data=prepare_cbk;
+	 control_port_caps->release_callback_data=release_cbk;
+
+ }
+
  void DSPlug_ControlPortCreation_set_musical_part(DSPlug_ControlPortCreation *p_port, int p_part) {
 
 	 DSPlug_ControlPortCapsPrivate *control_port_caps = (DSPlug_ControlPortCapsPrivate *)p_port->_private;
@@ -703,6 +864,20 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 
  }
 
+ void DSPlug_PluginCreation_set_control_numerical_batch_callback( DSPlug_PluginCreation *p_plugin_creation , void (*c)(DSPlug_Plugin, const int *, const float *, int) ) {
+
+	 DSPlug_PluginCapsPrivate *plugin_caps = (DSPlug_PluginCapsPrivate *)p_plugin_creation->_private;
+
+	 if (!p_plugin_creation || !plugin_caps) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_PluginCreation_set_control_numerical_batch_callback: Invalid PluginCreation object (NULL)");
+		 return;
+	 }
+
+	 plugin_caps->set_numerical_batch_callback=c;
+
+ }
+
 /*********
  * Plugin *
 **********/
@@ -764,13 +939,13 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		 return NULL;
 	 }
 
-	 if (c<0 || c>=plugin->audio_ports[p]->channel_count) {
+	 if (c<0 || c>=plugin->audio_ports[p].channel_count) {
 
 		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_audio_port_channel_buffer: Invalid Channel Index");
 		 return NULL;
 	 }
 
-	 return plugin->audio_ports[p]->channel_buffer_ptr[c];
+	 return plugin->audio_ports[p].channel_buffer_ptr[c];
 
  }
 
@@ -789,13 +964,13 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		 return NULL;
 	 }
 
-	 if (c<0 || c>=plugin->audio_ports[p]->channel_count) {
+	 if (c<0 || c>=plugin->audio_ports[p].channel_count) {
 
 		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_audio_port_channel_buffer_pointer: Invalid Channel Index");
 		 return NULL;
 	 }
 
-	 return &plugin->audio_ports[p]->channel_buffer_ptr[c];
+	 return &plugin->audio_ports[p].channel_buffer_ptr[c];
 
  }
 
@@ -817,7 +992,7 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		 return NULL;
 	 }
 
-	 return plugin->event_ports[p]->queue;
+	 return plugin->event_ports[p].queue;
 
  }
 
@@ -836,32 +1011,259 @@ DSPlug_ControlPortCreation * DSPlug_ControlPortCreation_create_numerical_bool( v
 		 return NULL;
 	 }
 
-	 return &plugin->event_ports[p]->queue;
+	 return &plugin->event_ports[p].queue;
+
+
+ }
+
+ /* Input event merging, the heap is a binary min-heap ordered by frame, then port */
+
+ static DSPlug_Boolean DSPlug_EventMergeEntry_less( const DSPlug_EventMergeEntry *a, const DSPlug_EventMergeEntry *b ) {
+
+	 return (a->frame<b->frame || (a->frame==b->frame && a->port<b->port)) ? DSPLUG_TRUE : DSPLUG_FALSE;
+ }
+
+ static void DSPlug_Plugin_event_merge_sift_down( DSPlug_PluginPrivate *plugin, int pos ) {
+
+	 DSPlug_EventMergeEntry *heap=plugin->event_merge_heap;
+	 DSPlug_EventMergeEntry aux;
+	 int child;
+
+	 while ( (child=pos*2+1) < plugin->event_merge_heap_size ) {
+
+		 if (child+1<plugin->event_merge_heap_size && DSPlug_EventMergeEntry_less(&heap[child+1],&heap[child]))
+			 child++;
+
+		 if (!DSPlug_EventMergeEntry_less(&heap[child],&heap[pos]))
+			 break;
+
+		 aux=heap[pos];
+		 heap[pos]=heap[child];
+		 heap[child]=aux;
+		 pos=child;
+	 }
+ }
+
+ /* The queue of the port seems empty, clear its pending bit. It's looked at again
+    afterwards, since a push in between would have found the bit still set */
+ static const DSPlug_Event * DSPlug_Plugin_event_port_drained( DSPlug_PluginPrivate *plugin, int port ) {
+
+	 volatile unsigned int *word=&plugin->pending_input_event_ports[port/32];
+	 unsigned int bit=1U<<(port%32);
+	 const DSPlug_Event *head;
+
+	 DSPLUG_ATOMIC_FETCH_AND(word,~bit);
+
+	 if (!plugin->event_ports[port].queue)
+		 return NULL;
+
+	 head=DSPlug_EventQueue_peek(plugin->event_ports[port].queue);
+	 if (head)
+		 DSPLUG_ATOMIC_FETCH_OR(word,bit);
+
+	 return head;
+ }
+
+ void DSPlug_Plugin_begin_input_events( DSPlug_Plugin p_plugin ) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
+	 const DSPlug_Event *head;
+	 unsigned int bits;
+	 int word,port,i;
+
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_begin_input_events: Invalid Plugin object (NULL)");
+		 return;
+	 }
+
+	 plugin->event_merge_heap_size=0;
+
+	 /* Only the ports whose queues got events are looked at, whole words of idle ports are skipped at once */
+	 for (word=0;word*32<plugin->event_port_count;word++) {
+
+		 bits=plugin->pending_input_event_ports[word]|plugin->polled_input_event_ports[word];
+
+		 for (port=word*32;bits;bits>>=1,port++) {
 
+			 if (!(bits&1))
+				 continue;
 
+			 head=plugin->event_ports[port].queue ? DSPlug_EventQueue_peek(plugin->event_ports[port].queue) : NULL;
+			 if (!head)
+				 head=DSPlug_Plugin_event_port_drained(plugin,port); /* the plugin popped them by itself */
+			 if (!head)
+				 continue;
+
+			 plugin->event_merge_heap[plugin->event_merge_heap_size].frame=head->frame;
+			 plugin->event_merge_heap[plugin->event_merge_heap_size].port=port;
+			 plugin->event_merge_heap_size++;
+		 }
+	 }
+
+	 for (i=plugin->event_merge_heap_size/2-1;i>=0;i--)
+		 DSPlug_Plugin_event_merge_sift_down(plugin,i);
+ }
+
+ DSPlug_Boolean DSPlug_Plugin_get_next_input_event( DSPlug_Plugin p_plugin, DSPlug_Event *ev, int *p ) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
+	 DSPlug_EventQueue *queue;
+	 const DSPlug_Event *head;
+
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_next_input_event: Invalid Plugin object (NULL)");
+		 return DSPLUG_FALSE;
+	 }
+
+	 if (plugin->event_merge_heap_size==0)
+		 return DSPLUG_FALSE;
+
+	 *p=plugin->event_merge_heap[0].port;
+	 queue=plugin->event_ports[*p].queue;
+	 DSPlug_EventQueue_pop(queue,ev);
+
+	 /* Reinsert the port with its next event, or drop it if it ran out of them */
+	 head=DSPlug_EventQueue_peek(queue);
+	 if (!head)
+		 head=DSPlug_Plugin_event_port_drained(plugin,*p);
+
+	 if (head)
+		 plugin->event_merge_heap[0].frame=head->frame;
+	 else
+		 plugin->event_merge_heap[0]=plugin->event_merge_heap[--plugin->event_merge_heap_size];
+
+	 DSPlug_Plugin_event_merge_sift_down(plugin,0);
+
+	 return DSPLUG_TRUE;
  }
 
  /* Control */
 
- void DSPlug_Plugin_UI_conntrol_port_value_changed_notify( DSPlug_Plugin p_plugin , int p) {
+ void DSPlug_Plugin_get_control_ramp( DSPlug_Plugin p_plugin, int p, DSPlug_ControlRamp *r ) {
 
 	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
 
 	 if (!plugin) {
-		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_UI_conntrol_port_value_changed_notify: Invalid Plugin object (NULL)");
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_ramp: Invalid Plugin object (NULL)");
 		 return;
 	 }
 
 	 if (p<0 || p>=plugin->control_port_count) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_ramp: Invalid Control Port Index");
+		 return;
+	 }
+
+	 DSPlug_Smoother_get_ramp(&plugin->control_ports[p].smoother,plugin->plugin_caps->control_port_caps[p],r);
+ }
+
+ void DSPlug_Plugin_render_control_ramp( DSPlug_Plugin p_plugin, int p, float *b, int f ) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
 
-		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_UI_conntrol_port_value_changed_notify: Invalid Port Index");
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_render_control_ramp: Invalid Plugin object (NULL)");
 		 return;
 	 }
 
-	 if (plugin->control_ports[p]->UI_changed_callback)
-		 plugin->control_ports[p]->UI_changed_callback(p,plugin->control_ports[p]->UI_changed_callback_userdata);
+	 if (p<0 || p>=plugin->control_port_count) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_render_control_ramp: Invalid Control Port Index");
+		 return;
+	 }
+
+	 DSPlug_Smoother_render(&plugin->control_ports[p].smoother,plugin->plugin_caps->control_port_caps[p],b,f);
+ }
+
+ const float * DSPlug_Plugin_get_control_port_modulation_buffer( DSPlug_Plugin p_plugin, int p ) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
+
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_modulation_buffer: Invalid Plugin object (NULL)");
+		 return NULL;
+	 }
+
+	 if (p<0 || p>=plugin->control_port_count) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_modulation_buffer: Invalid Control Port Index");
+		 return NULL;
+	 }
+
+	 return plugin->control_ports[p].modulation_buffer_ptr;
+ }
+
+ void * DSPlug_Plugin_get_control_port_data_object( DSPlug_Plugin p_plugin, int p ) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
+
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_data_object: Invalid Plugin object (NULL)");
+		 return NULL;
+	 }
+
+	 if (p<0 || p>=plugin->control_port_count) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_data_object: Invalid Control Port Index");
+		 return NULL;
+	 }
+
+	 return plugin->control_ports[p].data_current;
+ }
+
+ const char * DSPlug_Plugin_get_control_port_string( DSPlug_Plugin p_plugin , int p ) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
+	 DSPlug_ControlPortPrivate *port;
+
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_string: Invalid Plugin object (NULL)");
+		 return NULL;
+	 }
+
+	 if (p<0 || p>=plugin->control_port_count || !plugin->plugin_caps->control_port_caps[p]->managed_string) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_string: Invalid Control Port Index, or not a managed string port");
+		 return NULL;
+	 }
+
+	 port=&plugin->control_ports[p];
+
+	 return &port->string_buffers[port->string_front*(plugin->plugin_caps->control_port_caps[p]->realtime_port_string_max_len+1)];
+ }
+
+ int DSPlug_Plugin_get_control_port_string_option( DSPlug_Plugin p_plugin , int p ) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
+
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_string_option: Invalid Plugin object (NULL)");
+		 return -1;
+	 }
+
+	 if (p<0 || p>=plugin->control_port_count || !plugin->plugin_caps->control_port_caps[p]->managed_string) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_get_control_port_string_option: Invalid Control Port Index, or not a managed string port");
+		 return -1;
+	 }
+
+	 return plugin->control_ports[p].string_options[plugin->control_ports[p].string_front];
+ }
+
+ void DSPlug_Plugin_UI_value_changed_notify( DSPlug_Plugin p_plugin , int p) {
+
+	 DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate*)p_plugin._private;
+
+	 if (!plugin) {
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_UI_value_changed_notify: Invalid Plugin object (NULL)");
+		 return;
+	 }
+
+	 if (p<0 || p>=plugin->control_port_count) {
+
+		 DSPlug_report_error("PLUGIN: DSPlug_Plugin_UI_value_changed_notify: Invalid Port Index");
+		 return;
+	 }
 
+	 DSPlug_mark_control_port_changed(plugin,p);
 
+	 /* only mark it, the host drains the changes from its UI thread */
+	 DSPLUG_ATOMIC_FETCH_OR(&plugin->UI_dirty[p/32],1U<<(p%32));
+	 DSPLUG_ATOMIC_FETCH_OR(&plugin->UI_summary[p/1024],1U<<((p/32)%32));
  }
 
 
@@ -51,6 +51,7 @@ typedef struct {
 	DSPlug_CommonPortCapsPrivate common; /**< Basic Inheritance form, if GTK does this, I can too, this must always be the first member of the struct */
 
 	DSPlug_EventType event_type;
+	int capacity_hint; /**< events per cycle the plugin expects, 0 if it doesn't care */
 
 } DSPlug_EventPortCapsPrivate;
 
@@ -87,16 +88,38 @@ typedef struct {
 
 	int realtime_port_string_max_len;
 
+	/* Library managed strings, string ports only */
+
+	DSPlug_Boolean managed_string; /**< the library keeps the value, see DSPlug_ControlPortCreation_create_string_managed */
+	char **string_options; /**< known values, interned, their index is their id */
+	unsigned int *string_option_hashes;
+	int string_option_count;
+	int *string_option_slots; /**< open addressing over the options, -1 if empty */
+	unsigned int string_option_mask; /**< slot count -1 */
+
+	/* Smoothing, numerical ports only */
+
+	DSPlug_SmoothingMode smoothing_mode;
+	float smoothing_time; /**< in seconds */
+
+	/* Audio rate modulation, numerical ports only */
+
+	DSPlug_Boolean modulation_input; /**< plugin reads the modulation buffer, otherwise the library decimates it */
+
 	/* Callback to Plugin when setting and getting ports */
 
 	void (*set_callback_numerical)(DSPlug_Plugin , int, float); /**< Callback to float value set */
 	void (*set_callback_string)(DSPlug_Plugin , int, const char *); /**< Callback to string value set */
 	void (*set_callback_data)(DSPlug_Plugin , int, const void *, int); /**< Callback to data value set */
 
+	void * (*prepare_callback_data)(DSPlug_Plugin , int, const void *, int); /**< Asynchronous data, builds the object on a worker thread, optional */
+	void (*release_callback_data)(DSPlug_Plugin , int, void *); /**< Asynchronous data, frees an object off the realtime thread */
+
 	float (*get_callback_numerical)(DSPlug_Plugin , int); /**< Callback to float value get */
 	char * (*get_callback_string)(DSPlug_Plugin , int); /**< Callback to string value get, not realtime */
 	void (*get_callback_string_realtime)(DSPlug_Plugin , int, char *); /**< Callback to string value get */
 	void (*get_callback_data)(DSPlug_Plugin , int, void **, int*); /**< Callback to data value get */
+	DSPlug_DataBuffer * (*get_callback_data_buffer)(DSPlug_Plugin , int); /**< Callback to data value get, as a new reference to a buffer, optional */
 
 } DSPlug_ControlPortCapsPrivate;
 
@@ -117,12 +140,60 @@ typedef struct {
 typedef struct {
 
 	DSPlug_EventQueue * queue; /**< Pointer to the Event Queue */
+	DSPlug_EventQueue * generated_queue; /**< Queue filled by the library, only for AUDIO input ports */
+
+	DSPlug_EventQueue * recorded_queue; /**< queue recorded_pos belongs to, NULL if nothing was recorded yet */
+	unsigned int recorded_pos; /**< ring position of the first event not recorded yet */
 
 } DSPlug_EventPortPrivate;
 
+/**
+ * Entry of the heap used to merge the input event ports by frame
+ */
+typedef struct {
+
+	int frame; /**< frame of the next pending event of the port */
+	int port;
+
+} DSPlug_EventMergeEntry;
+
+
+/**
+ * Ramp state of a smoothed numerical port, see dsplug_smoother.h
+ */
+typedef struct {
+
+	DSPlug_Boolean primed; /**< false until the first value is set */
+	float current; /**< value at the beginning of the next block */
+	float target;
+	float step; /**< linear modes */
+	int remaining; /**< linear modes, frames until target */
+	float coefficient; /**< exponential mode, computed at instance time */
+	float rate; /**< linear mode, maximum change per frame */
+	int fixed_frames; /**< fixed time mode, frames of a ramp */
+
+} DSPlug_SmootherPrivate;
 
 typedef struct {
 
+	DSPlug_SmootherPrivate smoother;
+
+	const float *modulation_buffer; /* connected by the host, NULL if none */
+	const float *modulation_buffer_ptr; /* modulation_buffer at the block being processed */
+
+	/* Asynchronous data ports, objects made by prepare_callback_data */
+	void * volatile data_pending; /* published by a worker thread, taken at the beginning of a cycle */
+	void *data_current; /* the one the plugin uses */
+	void * volatile data_retired; /* replaced at the beginning of a cycle, released by the host */
+
+	/* Library managed strings, three buffers so setting never waits for the plugin */
+	char *string_buffers; /* 3 times realtime_port_string_max_len+1 */
+	int string_options[3]; /* interned id of every buffer, -1 if not an option */
+	int string_front; /* the one the plugin reads, swapped at the beginning of a cycle */
+	volatile int string_middle; /* last one set, with DSPLUG_STRING_BUFFER_FRESH until taken */
+	int string_back; /* the one the next set writes */
+	int string_last; /* last one set, read back by the setting thread */
+
 	void (*UI_changed_callback)(int, void *); /* ui changed port index, */
 	void * UI_changed_callback_userdata;
 
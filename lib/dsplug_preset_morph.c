@@ -0,0 +1,296 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_host.h"
+#include "dsplug_private.h"
+#include "dsplug_error_report.h"
+#include "dsplug_state.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DSPLUG_PRESET_MORPH_ROW_ALIGNMENT 4 /* in floats, keeps every row aligned as the first one */
+
+typedef struct {
+
+	DSPlug_PluginInstance *instance;
+
+	int snapshot_count;
+	int port_count;
+	int stride; /**< floats per snapshot row */
+
+	int *ports; /**< control port index of every morphed port */
+	int *positions; /**< morphed port of every control port, -1 if not morphed */
+	float *values; /**< snapshot_count rows of stride floats */
+	float *blended;
+
+	/* Morphed ports that are not interpolated */
+	int *integer_items;
+	float *integer_steps;
+	int integer_count;
+	int *enum_items;
+	int enum_count;
+	int *bool_items;
+	int bool_count;
+
+} DSPlug_PresetMorphPrivate;
+
+
+DSPlug_PresetMorph * DSPlug_PresetMorph_create( DSPlug_PluginInstance *p_instance, int n ) {
+
+	DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	DSPlug_PresetMorph *morph_public;
+	DSPlug_PresetMorphPrivate *morph;
+	DSPlug_ControlPortCapsPrivate *caps;
+	int i,j;
+
+	if (plugin_public==NULL || plugin==NULL) {
+
+		DSPlug_report_error("HOST: DSPlug_PresetMorph_create: Calling with NULL PluginInstance ");
+		return NULL;
+	}
+
+	if (n<1 || n>DSPLUG_PRESET_MORPH_MAX_SNAPSHOTS) {
+
+		DSPlug_report_error("HOST: DSPlug_PresetMorph_create: Invalid amount of snapshots ");
+		return NULL;
+	}
+
+	morph = (DSPlug_PresetMorphPrivate*)malloc(sizeof(DSPlug_PresetMorphPrivate));
+	memset(morph,0,sizeof(DSPlug_PresetMorphPrivate));
+
+	morph->instance=p_instance;
+	morph->snapshot_count=n;
+	morph->ports=(int*)malloc(sizeof(int)*(plugin->control_port_count+1));
+	morph->positions=(int*)malloc(sizeof(int)*(plugin->control_port_count+1));
+	morph->integer_items=(int*)malloc(sizeof(int)*(plugin->control_port_count+1));
+	morph->integer_steps=(float*)malloc(sizeof(float)*(plugin->control_port_count+1));
+	morph->enum_items=(int*)malloc(sizeof(int)*(plugin->control_port_count+1));
+	morph->bool_items=(int*)malloc(sizeof(int)*(plugin->control_port_count+1));
+
+	for (i=0;i<plugin->control_port_count;i++) {
+
+		caps=plugin->plugin_caps->control_port_caps[i];
+		morph->positions[i]=-1;
+
+		if (caps->type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL || caps->common.plug_type==DSPLUG_PLUG_OUTPUT)
+			continue;
+		if (!caps->set_callback_numerical || !caps->get_callback_numerical)
+			continue;
+
+		j=morph->port_count++;
+		morph->ports[j]=i;
+		morph->positions[i]=j;
+
+		switch (caps->numerical_hint) {
+
+			case DSPLUG_CONTROL_PORT_HINT_TYPE_INTEGER: {
+
+				if (caps->integer_is_enum) {
+
+					morph->enum_items[morph->enum_count++]=j;
+				} else {
+
+					morph->integer_items[morph->integer_count]=j;
+					morph->integer_steps[morph->integer_count]=(caps->integer_steps>0) ? caps->integer_steps : 1;
+					morph->integer_count++;
+				}
+			} break;
+			case DSPLUG_CONTROL_PORT_HINT_TYPE_BOOL: {
+
+				morph->bool_items[morph->bool_count++]=j;
+			} break;
+			default: {}
+		}
+	}
+
+	morph->stride=(morph->port_count+DSPLUG_PRESET_MORPH_ROW_ALIGNMENT-1)&~(DSPLUG_PRESET_MORPH_ROW_ALIGNMENT-1);
+	morph->values=(float*)malloc(sizeof(float)*(morph->stride*n+1));
+	morph->blended=(float*)malloc(sizeof(float)*(morph->stride+1));
+	memset(morph->values,0,sizeof(float)*morph->stride*n);
+
+	morph_public = (DSPlug_PresetMorph*)malloc(sizeof(DSPlug_PresetMorph));
+	morph_public->_private=morph;
+
+	for (i=0;i<n;i++)
+		DSPlug_PresetMorph_capture_snapshot(morph_public,i);
+
+	return morph_public;
+}
+
+void DSPlug_PresetMorph_destroy( DSPlug_PresetMorph *p_morph ) {
+
+	DSPlug_PresetMorphPrivate *morph;
+
+	if (!p_morph || !p_morph->_private) {
+
+		DSPlug_report_error("HOST: DSPlug_PresetMorph_destroy: Invalid PresetMorph object (NULL)");
+		return;
+	}
+
+	morph = (DSPlug_PresetMorphPrivate*)p_morph->_private;
+
+	free(morph->ports);
+	free(morph->positions);
+	free(morph->values);
+	free(morph->blended);
+	free(morph->integer_items);
+	free(morph->integer_steps);
+	free(morph->enum_items);
+	free(morph->bool_items);
+	free(morph);
+	free(p_morph);
+}
+
+void DSPlug_PresetMorph_capture_snapshot( DSPlug_PresetMorph *p_morph, int s ) {
+
+	DSPlug_PresetMorphPrivate *morph = (DSPlug_PresetMorphPrivate*)p_morph->_private;
+	DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)morph->instance->_private;
+	DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	float *row;
+	int i;
+
+	if (s<0 || s>=morph->snapshot_count) {
+
+		DSPlug_report_error("HOST: DSPlug_PresetMorph_capture_snapshot: Invalid snapshot index ");
+		return;
+	}
+
+	row=&morph->values[s*morph->stride];
+
+	for (i=0;i<morph->port_count;i++)
+		row[i]=plugin->plugin_caps->control_port_caps[morph->ports[i]]->get_callback_numerical(*plugin_public,morph->ports[i]);
+}
+
+DSPlug_Boolean DSPlug_PresetMorph_set_snapshot( DSPlug_PresetMorph *p_morph, int s, const void *b, int l ) {
+
+	DSPlug_PresetMorphPrivate *morph = (DSPlug_PresetMorphPrivate*)p_morph->_private;
+	DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)morph->instance->_private;
+	DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	DSPlug_StateHeader header;
+	DSPlug_StateEntryHeader entry;
+	DSPlug_PluginCaps plugin_caps;
+	const char *key,*value;
+	float *row;
+	unsigned int i;
+	int pos,port;
+
+	if (s<0 || s>=morph->snapshot_count) {
+
+		DSPlug_report_error("HOST: DSPlug_PresetMorph_set_snapshot: Invalid snapshot index ");
+		return DSPLUG_FALSE;
+	}
+
+	if (!DSPlug_state_check((const char*)b,l,&header))
+		return DSPLUG_FALSE;
+
+	DSPlug_PresetMorph_capture_snapshot(p_morph,s);
+
+	row=&morph->values[s*morph->stride];
+	plugin_caps._private=plugin->plugin_caps;
+	pos=sizeof(DSPlug_StateHeader);
+
+	for (i=0;i<header.entry_count;i++) {
+
+		DSPlug_state_read_entry((const char*)b,header.size,&pos,&entry,&key,&value);
+
+		if (entry.type!=DSPLUG_CONTROL_PORT_TYPE_NUMERICAL)
+			continue;
+
+		port=DSPlug_PluginCaps_find_port(plugin_caps,DSPLUG_PORT_CONTROL,key);
+
+		if (port<0 || morph->positions[port]<0)
+			continue;
+
+		memcpy(&row[morph->positions[port]],value,sizeof(float));
+	}
+
+	return DSPLUG_TRUE;
+}
+
+void DSPlug_PresetMorph_apply( DSPlug_PresetMorph *p_morph, const float *w, DSPlug_Boolean m ) {
+
+	DSPlug_PresetMorphPrivate *morph = (DSPlug_PresetMorphPrivate*)p_morph->_private;
+	DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)morph->instance->_private;
+	DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	float *out=morph->blended;
+	const float *row;
+	float weight,v;
+	int port_count=morph->port_count;
+	int dominant=0;
+	int i,s;
+
+	if (!w) {
+
+		DSPlug_report_error("HOST: DSPlug_PresetMorph_apply: NULL weights ");
+		return;
+	}
+
+	if (m && !plugin->mailbox_values) {
+
+		DSPlug_report_error("HOST: DSPlug_PresetMorph_apply: Control mailbox is disabled ");
+		return;
+	}
+
+	if (port_count==0)
+		return;
+
+	/* Weighted sum of the rows, plain loops over contiguous floats */
+	for (i=0;i<port_count;i++)
+		out[i]=0;
+
+	for (s=0;s<morph->snapshot_count;s++) {
+
+		weight=w[s];
+		if (weight>w[dominant])
+			dominant=s;
+		if (weight==0)
+			continue;
+
+		row=&morph->values[s*morph->stride];
+
+		for (i=0;i<port_count;i++)
+			out[i]+=weight*row[i];
+	}
+
+	for (i=0;i<port_count;i++)
+		out[i]=(out[i]<0) ? 0 : ((out[i]>1) ? 1 : out[i]);
+
+	/* Ports that can't be interpolated */
+	for (i=0;i<morph->integer_count;i++) {
+
+		v=out[morph->integer_items[i]]*morph->integer_steps[i];
+		out[morph->integer_items[i]]=(float)((int)(v+0.5f))/morph->integer_steps[i];
+	}
+
+	row=&morph->values[dominant*morph->stride];
+
+	for (i=0;i<morph->enum_count;i++)
+		out[morph->enum_items[i]]=row[morph->enum_items[i]];
+
+	for (i=0;i<morph->bool_count;i++)
+		out[morph->bool_items[i]]=(out[morph->bool_items[i]]>=0.5f) ? 1.0f : 0.0f;
+
+	if (m) {
+
+		for (i=0;i<port_count;i++)
+			DSPlug_PluginInstance_post_control_numerical_port(morph->instance,morph->ports[i],out[i]);
+	} else {
+
+		DSPlug_PluginInstance_set_control_numerical_ports(morph->instance,morph->ports,out,port_count);
+	}
+}
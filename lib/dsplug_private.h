@@ -20,6 +20,7 @@
 
 #include "dsplug_types.h"
 #include "dsplug_port_info_private.h"
+#include "dsplug_automation.h"
 
 /* ////////////////////////////////////////////////////////// */
 
@@ -29,6 +30,31 @@
 #define MAX_PLUGIN_CAPS_CONSTANTS 32
 #define MAX_PLUGIN_CAPS_FEATURE_BYTES 16
 
+/* Port lookup, open addressing hash tables, one for the port names and one for the full path/name */
+
+typedef struct {
+
+	unsigned int hash;
+	int port; /* -1 if the slot is empty */
+
+} DSPlug_PortIndexSlot;
+
+typedef struct {
+
+	DSPlug_PortIndexSlot *name_slots;
+	DSPlug_PortIndexSlot *path_slots;
+	unsigned int mask; /* slot count -1, slot count is a power of two */
+
+} DSPlug_PortIndexPrivate;
+
+/* Entry of the change log of an instance, the port is written before the generation */
+typedef struct {
+
+	volatile unsigned int generation;
+	volatile int port;
+
+} DSPlug_ChangeLogEntry;
+
 typedef struct {
 
 	/* If no errors on the creation happened, this is true */
@@ -65,6 +91,13 @@ typedef struct {
 	DSPlug_ControlPortCapsPrivate **control_port_caps;
 	int control_port_count;
 
+	/* Port lookup by name or path, for every DSPlug_PortType, built when the plugin is added */
+	DSPlug_PortIndexPrivate port_index[3];
+
+	/* Control ports of every musical part, built when the plugin is added */
+	int musical_part_count; /* highest part used +1 */
+	int *musical_part_offsets; /* musical_part_count+1 entries, ports of part N are musical_part_ports[offsets[N]] to musical_part_ports[offsets[N+1]-1] */
+	int *musical_part_ports; /* control port indices, in the order they were added */
 
 	/* Bitmask for Features */
 
@@ -88,6 +121,10 @@ typedef struct {
 
 	int  (*get_output_delay_callback)(DSPlug_Plugin *);
 
+	/* Batched numerical port set, optional */
+
+	void (*set_numerical_batch_callback)(DSPlug_Plugin, const int *, const float *, int);
+
 } DSPlug_PluginCapsPrivate;
 
 
@@ -96,6 +133,25 @@ typedef struct {
 
 /* Plugin Instance */
 
+#define DSPLUG_TRANSPORT_QUEUE_CAPACITY 64
+#define DSPLUG_CHANGE_LOG_MIN_SIZE 256 /* entries of the change log, at least four per control port */
+
+/**
+ * Transport state, sent to the AUDIO input event ports every cycle
+ */
+typedef struct {
+
+	double position; /* in frames, at the beginning of the next cycle */
+	DSPlug_Boolean playing;
+	double loop_begin;
+	double loop_end; /* looping is disabled when not after loop_begin */
+	int upstream_latency;
+
+} DSPlug_TransportPrivate;
+
+/* An instance, with its ports and the arrays below, is a single block
+   starting with the DSPlug_PluginInstance, see DSPlug_PluginInstance_layout.
+   Only the optional parts (mailbox, automation, generated queues) are apart */
 typedef struct {
 
 	/**
@@ -104,17 +160,72 @@ typedef struct {
 	 */
 	DSPlug_PluginCapsPrivate * plugin_caps;
 
-	DSPlug_AudioPortPrivate **audio_ports;
+	DSPlug_AudioPortPrivate *audio_ports;
 	int audio_port_count;
 
-	DSPlug_EventPortPrivate **event_ports;
+	DSPlug_EventPortPrivate *event_ports;
 	int event_port_count;
 
-	DSPlug_ControlPortPrivate **control_ports;
+	/* Input event port merging */
+	volatile unsigned int pending_input_event_ports[DSPLUG_MAX_EVENT_PORTS/32]; /* set by the producers on push, cleared by the merge when a queue runs out of events */
+	unsigned int polled_input_event_ports[DSPLUG_MAX_EVENT_PORTS/32]; /* connected to queues that notify another consumer, they are looked at every time */
+	DSPlug_EventMergeEntry *event_merge_heap; /* min-heap by frame, one entry per port with pending events */
+	int event_merge_heap_size;
+
+	DSPlug_ControlPortPrivate *control_ports;
 	int control_port_count;
 
+	int *smoothed_control_ports; /* indices of the ports with smoothing, they are advanced every block */
+	int smoothed_control_port_count;
+
+	int *modulated_control_ports; /* indices of the ports with a modulation buffer connected */
+	int modulated_control_port_count;
+
+	/* Automation is never edited in place: the host edits a copy of the newest lanes and publishes it */
+	DSPlug_AutomationPrivate *automation; /* lanes being played, NULL until a lane is set */
+	void * volatile automation_pending; /* published by the host, taken at the beginning of a cycle */
+	void * volatile automation_retired; /* replaced at the beginning of a cycle, freed by the host */
+	DSPlug_AutomationPrivate *automation_latest; /* newest published lanes, owned by the host */
+
+	int *async_data_ports; /* indices of the asynchronous data ports, checked for new objects every cycle */
+	int async_data_port_count;
+	int *managed_string_ports; /* indices of the library managed string ports, checked for new strings every cycle */
+	int managed_string_port_count;
+	int *modulation_batch_ports; /* scratch, decimated modulation is set in a single batch */
+	float *modulation_batch_values;
+	int *state_batch_ports; /* scratch, numerical ports of a loaded snapshot are set in a single batch */
+	float *state_batch_values;
+	int *state_batch_slots; /* slot+1 of every port in the batch, 0 if not in it, so repeated entries take a single slot */
+
+	/* Control mailbox, NULL values if disabled */
+	volatile float *mailbox_values; /* last value posted to each control port */
+	volatile unsigned int *mailbox_dirty; /* bit per control port, set when posted */
+	volatile unsigned int *mailbox_summary; /* bit per mailbox_dirty word, set when it may be nonzero */
+	int mailbox_summary_words;
+	int *mailbox_batch_ports; /* scratch, the dirty ports of a cycle are set in a single batch */
+	float *mailbox_batch_values;
+
+	/* Change tracking, generations only grow (wrapping around) */
+	volatile unsigned int change_generation; /* generation of the last change */
+	volatile unsigned int *port_generations; /* generation of the last change of every control port, 0 if never changed */
+	DSPlug_ChangeLogEntry *change_log; /* ring with the last changes, indexed by generation */
+	unsigned int change_log_mask; /* entry count -1, entry count is a power of two */
+
+	/* UI notifications, set by the plugin from any thread, drained by the UI */
+	volatile unsigned int *UI_dirty; /* bit per control port, set when notified */
+	volatile unsigned int *UI_summary; /* bit per UI_dirty word, set when it may be nonzero */
+	int UI_summary_words;
+
 	DSPlug_Boolean inside_process_callback_flag; /* This flag is on when plugin is inside process callback */
 
+	/* Sub-block splitting */
+	DSPlug_Boolean sub_block_splitting; /* split process() at control change offsets */
+	int sub_block_min_frames; /* minimum size of a sub-block */
+
+	DSPlug_TransportPrivate transport;
+
+	DSPlug_EventRecorder *event_recorder; /* if not NULL, input events are recorded here every cycle */
+
 	float sampling_rate; /* sampling rate in HZ at which the plugin was instanced */
 } DSPlug_PluginPrivate;
 
@@ -0,0 +1,145 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_smoother.h"
+
+#include <math.h>
+#include <string.h>
+
+/* Exponential ramps never really end, they snap to the target this close to it */
+#define DSPLUG_SMOOTHER_EPSILON 1e-6
+
+
+void DSPlug_Smoother_init(DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, float samplerate) {
+
+	double frames = caps->smoothing_time*samplerate; /* time in frames */
+
+	memset(s,0,sizeof(DSPlug_SmootherPrivate));
+
+	if (frames<1.0)
+		return; /* too short to smooth anything, values jump */
+
+	s->coefficient=(float)exp(-1.0/frames);
+	s->rate=(float)(1.0/frames);
+	s->fixed_frames=(int)frames;
+}
+
+void DSPlug_Smoother_set_target(DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, float v) {
+
+	float distance;
+	int frames=0;
+
+	s->target=v;
+
+	if (!s->primed || s->fixed_frames==0) {
+
+		/* nothing to smooth from, or smoothing too short */
+		s->primed=DSPLUG_TRUE;
+		s->current=v;
+		s->remaining=0;
+		return;
+	}
+
+	distance=v-s->current;
+
+	switch(caps->smoothing_mode) {
+
+		case DSPLUG_SMOOTHING_LINEAR: {
+
+			frames=(int)(fabs(distance)/s->rate);
+			if (frames*s->rate<fabs(distance))
+				frames++;
+		} break;
+		case DSPLUG_SMOOTHING_FIXED_TIME: {
+
+			frames=(distance!=0.0f)?s->fixed_frames:0;
+		} break;
+		default: {} /* exponential ramps only need the target */
+	}
+
+	s->remaining=frames;
+	s->step=(frames>0)?distance/frames:0.0f;
+
+	if (caps->smoothing_mode!=DSPLUG_SMOOTHING_EXPONENTIAL && frames==0)
+		s->current=v;
+}
+
+void DSPlug_Smoother_advance(DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, int f) {
+
+	double distance;
+
+	if (caps->smoothing_mode==DSPLUG_SMOOTHING_EXPONENTIAL) {
+
+		if (s->current==s->target)
+			return;
+
+		distance=(s->current-s->target)*pow(s->coefficient,f);
+		s->current = (fabs(distance)<DSPLUG_SMOOTHER_EPSILON) ? s->target : (float)(s->target+distance);
+		return;
+	}
+
+	if (s->remaining==0)
+		return;
+
+	if (f>=s->remaining) {
+
+		s->current=s->target; /* exact, no accumulated error */
+		s->remaining=0;
+	} else {
+
+		s->current+=s->step*f;
+		s->remaining-=f;
+	}
+}
+
+void DSPlug_Smoother_get_ramp(const DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, DSPlug_ControlRamp *r) {
+
+	r->mode=caps->smoothing_mode;
+	r->start=s->current;
+	r->target=s->target;
+	r->step=s->step;
+	r->frames=s->remaining;
+	r->coefficient=s->coefficient;
+}
+
+void DSPlug_Smoother_render(const DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, float *b, int f) {
+
+	float value=s->current;
+	float distance;
+	int i=0,ramp;
+
+	if (caps->smoothing_mode==DSPLUG_SMOOTHING_EXPONENTIAL) {
+
+		if (value!=s->target) {
+
+			for (distance=value-s->target;i<f;i++) {
+
+				distance*=s->coefficient;
+				b[i]=s->target+distance;
+			}
+		}
+
+	} else {
+
+		ramp=(s->remaining<f)?s->remaining:f;
+
+		for (;i<ramp;i++)
+			b[i]=value+s->step*(i+1);
+	}
+
+	for (;i<f;i++)
+		b[i]=s->target;
+}
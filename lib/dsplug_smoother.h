@@ -0,0 +1,34 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DSPLUG_SMOOTHER_H
+#define DSPLUG_SMOOTHER_H
+
+#include "dsplug_port_info_private.h"
+
+/*
+	Ramps of smoothed numerical ports. Setting a value only computes the ramp,
+	the values of a block are rendered on demand by the plugin, and advancing
+	a block is done in closed form, so ports nobody reads cost nearly nothing.
+*/
+
+void DSPlug_Smoother_init(DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, float samplerate);
+void DSPlug_Smoother_set_target(DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, float v);
+void DSPlug_Smoother_advance(DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, int f);
+void DSPlug_Smoother_get_ramp(const DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, DSPlug_ControlRamp *r);
+void DSPlug_Smoother_render(const DSPlug_SmootherPrivate *s, const DSPlug_ControlPortCapsPrivate *caps, float *b, int f);
+
+#endif
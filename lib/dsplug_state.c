@@ -0,0 +1,393 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_host.h"
+#include "dsplug_private.h"
+#include "dsplug_error_report.h"
+#include "dsplug_state.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+typedef struct {
+
+	char *buffer;
+	int size;
+	int capacity;
+
+} DSPlug_StateWriter;
+
+
+/****************************/
+
+/* SAVING */
+
+/****************************/
+
+static void DSPlug_StateWriter_append( DSPlug_StateWriter *w, const void *d, int l ) {
+
+	if (w->size+l>w->capacity) {
+
+		while (w->size+l>w->capacity)
+			w->capacity*=2;
+		w->buffer=(char*)realloc(w->buffer,w->capacity);
+	}
+
+	if (d)
+		memcpy(&w->buffer[w->size],d,l);
+	else
+		memset(&w->buffer[w->size],0,l);
+
+	w->size+=l;
+}
+
+static void DSPlug_StateWriter_add_entry( DSPlug_StateWriter *w, DSPlug_ControlPortCapsPrivate *caps, const void *v, int l ) {
+
+	DSPlug_StateEntryHeader entry;
+	int path_length=strlen(caps->common.path);
+	int separator=(path_length==0 || caps->common.path[path_length-1]!='/') ? 1 : 0;
+	int unpadded;
+
+	entry.type=caps->type;
+	entry.key_length=path_length+separator+strlen(caps->common.name)+1;
+	entry.value_length=l;
+
+	unpadded=sizeof(DSPlug_StateEntryHeader)+entry.key_length+entry.value_length;
+	entry.size=(unpadded+DSPLUG_STATE_ALIGNMENT-1)&~(DSPLUG_STATE_ALIGNMENT-1);
+
+	DSPlug_StateWriter_append(w,&entry,sizeof(DSPlug_StateEntryHeader));
+	DSPlug_StateWriter_append(w,caps->common.path,path_length);
+	if (separator)
+		DSPlug_StateWriter_append(w,"/",1);
+	DSPlug_StateWriter_append(w,caps->common.name,strlen(caps->common.name)+1);
+	DSPlug_StateWriter_append(w,v,l);
+	DSPlug_StateWriter_append(w,NULL,entry.size-unpadded);
+}
+
+void * DSPlug_PluginInstance_save_state( DSPlug_PluginInstance *p_instance, int *l ) {
+
+	DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	DSPlug_ControlPortCapsPrivate *caps;
+	DSPlug_StateWriter writer;
+	DSPlug_StateHeader header;
+	float value;
+	char *string;
+	DSPlug_DataBuffer *data;
+	int i;
+
+	if (plugin_public==NULL || plugin==NULL) {
+
+		DSPlug_report_error("HOST: DSPlug_PluginInstance_save_state: Calling with NULL PluginInstance ");
+		return NULL;
+	}
+
+	if (!l) {
+
+		DSPlug_report_error("HOST: DSPlug_PluginInstance_save_state: NULL length pointer ");
+		return NULL;
+	}
+
+	memset(&header,0,sizeof(DSPlug_StateHeader));
+	memcpy(header.magic,DSPLUG_STATE_MAGIC,8);
+	header.version=DSPLUG_STATE_VERSION;
+	header.byte_order=DSPLUG_STATE_BYTE_ORDER;
+
+	writer.capacity=1024;
+	writer.size=0;
+	writer.buffer=(char*)malloc(writer.capacity);
+
+	DSPlug_StateWriter_append(&writer,&header,sizeof(DSPlug_StateHeader)); /* rewritten at the end */
+
+	for (i=0;i<plugin->control_port_count;i++) {
+
+		caps=plugin->plugin_caps->control_port_caps[i];
+
+		if (caps->common.plug_type==DSPLUG_PLUG_OUTPUT)
+			continue;
+
+		switch (caps->type) {
+
+			case DSPLUG_CONTROL_PORT_TYPE_NUMERICAL: {
+
+				if (!caps->get_callback_numerical)
+					continue;
+
+				value=caps->get_callback_numerical(*plugin_public,i);
+				DSPlug_StateWriter_add_entry(&writer,caps,&value,sizeof(float));
+
+			} break;
+			case DSPLUG_CONTROL_PORT_TYPE_STRING: {
+
+				if (caps->get_callback_string) {
+
+					string=caps->get_callback_string(*plugin_public,i);
+
+				} else if (caps->get_callback_string_realtime || caps->managed_string) {
+
+					string=(char*)malloc(caps->realtime_port_string_max_len+1);
+					string[0]=0;
+					DSPlug_PluginInstance_get_control_string_port_realtime(p_instance,i,string);
+					string[caps->realtime_port_string_max_len]=0;
+				} else
+					continue;
+
+				if (!string)
+					continue;
+
+				DSPlug_StateWriter_add_entry(&writer,caps,string,strlen(string)+1);
+				free(string);
+
+			} break;
+			case DSPLUG_CONTROL_PORT_TYPE_DATA: {
+
+				if (!caps->get_callback_data && !caps->get_callback_data_buffer)
+					continue;
+
+				data=DSPlug_PluginInstance_get_control_port_data_buffer(p_instance,i); /* no copy, if the plugin supports it */
+
+				if (!data)
+					continue;
+
+				DSPlug_StateWriter_add_entry(&writer,caps,DSPlug_DataBuffer_get_data(data),DSPlug_DataBuffer_get_length(data));
+				DSPlug_DataBuffer_release(data);
+
+			} break;
+			default: continue;
+		}
+
+		header.entry_count++;
+	}
+
+	header.size=writer.size;
+	memcpy(writer.buffer,&header,sizeof(DSPlug_StateHeader));
+
+	*l=writer.size;
+	return writer.buffer;
+}
+
+
+/****************************/
+
+/* LOADING */
+
+/****************************/
+
+DSPlug_Boolean DSPlug_state_read_entry( const char *b, int l, int *pos, DSPlug_StateEntryHeader *entry, const char **key, const char **value ) {
+
+	if (*pos+(int)sizeof(DSPlug_StateEntryHeader)>l)
+		return DSPLUG_FALSE;
+
+	memcpy(entry,&b[*pos],sizeof(DSPlug_StateEntryHeader)); /* the buffer may be unaligned */
+
+	if (entry->key_length<1 || entry->key_length>(unsigned int)l || entry->value_length>(unsigned int)l)
+		return DSPLUG_FALSE;
+
+	if (entry->size<sizeof(DSPlug_StateEntryHeader)+entry->key_length+entry->value_length || entry->size>(unsigned int)(l-*pos))
+		return DSPLUG_FALSE;
+
+	*key=&b[*pos+sizeof(DSPlug_StateEntryHeader)];
+	*value=*key+entry->key_length;
+
+	if ((*key)[entry->key_length-1]!=0)
+		return DSPLUG_FALSE;
+
+	switch (entry->type) {
+
+		case DSPLUG_CONTROL_PORT_TYPE_NUMERICAL: {
+
+			if (entry->value_length!=sizeof(float))
+				return DSPLUG_FALSE;
+		} break;
+		case DSPLUG_CONTROL_PORT_TYPE_STRING: {
+
+			if (entry->value_length<1 || (*value)[entry->value_length-1]!=0)
+				return DSPLUG_FALSE;
+		} break;
+		case DSPLUG_CONTROL_PORT_TYPE_DATA: break;
+		default: return DSPLUG_FALSE;
+	}
+
+	*pos+=entry->size;
+
+	return DSPLUG_TRUE;
+}
+
+DSPlug_Boolean DSPlug_state_check( const char *b, int l, DSPlug_StateHeader *header ) {
+
+	DSPlug_StateEntryHeader entry;
+	const char *key,*value;
+	unsigned int i;
+	int pos;
+
+	if (!b || l<(int)sizeof(DSPlug_StateHeader)) {
+
+		DSPlug_report_error("HOST: DSPlug_state_check: Invalid state snapshot ");
+		return DSPLUG_FALSE;
+	}
+
+	memcpy(header,b,sizeof(DSPlug_StateHeader));
+
+	if (memcmp(header->magic,DSPLUG_STATE_MAGIC,8)!=0 || header->byte_order!=DSPLUG_STATE_BYTE_ORDER || header->size>(unsigned int)l || header->size<sizeof(DSPlug_StateHeader)) {
+
+		DSPlug_report_error("HOST: DSPlug_state_check: Invalid state snapshot, or saved in a different kind of machine ");
+		return DSPLUG_FALSE;
+	}
+
+	if (header->version!=DSPLUG_STATE_VERSION) {
+
+		DSPlug_report_error("HOST: DSPlug_state_check: Unsupported state snapshot version ");
+		return DSPLUG_FALSE;
+	}
+
+	pos=sizeof(DSPlug_StateHeader);
+
+	for (i=0;i<header->entry_count;i++) {
+
+		if (!DSPlug_state_read_entry(b,header->size,&pos,&entry,&key,&value)) {
+
+			DSPlug_report_error("HOST: DSPlug_state_check: Corrupt state snapshot ");
+			return DSPLUG_FALSE;
+		}
+	}
+
+	return DSPLUG_TRUE;
+}
+
+DSPlug_Boolean DSPlug_PluginInstance_load_state( DSPlug_PluginInstance *p_instance, const void *b, int l ) {
+
+	DSPlug_Plugin *plugin_public = (DSPlug_Plugin *)p_instance->_private;
+	DSPlug_PluginPrivate *plugin = (DSPlug_PluginPrivate *)plugin_public->_private;
+	const char *buffer=(const char*)b;
+	DSPlug_StateHeader header;
+	DSPlug_StateEntryHeader entry;
+	DSPlug_ControlPortCapsPrivate *caps;
+	DSPlug_PluginCaps plugin_caps;
+	const char *key,*value;
+	unsigned int i;
+	int pos,port,n=0;
+
+	if (plugin_public==NULL || plugin==NULL) {
+
+		DSPlug_report_error("HOST: DSPlug_PluginInstance_load_state: Calling with NULL PluginInstance ");
+		return DSPLUG_FALSE;
+	}
+
+	/* The whole snapshot is checked first, so a broken one doesn't get half loaded */
+	if (!DSPlug_state_check(buffer,l,&header))
+		return DSPLUG_FALSE;
+
+	l=header.size;
+
+	plugin_caps._private=plugin->plugin_caps;
+	pos=sizeof(DSPlug_StateHeader);
+
+	for (i=0;i<header.entry_count;i++) {
+
+		DSPlug_state_read_entry(buffer,l,&pos,&entry,&key,&value);
+
+		port=DSPlug_PluginCaps_find_port(plugin_caps,DSPLUG_PORT_CONTROL,key);
+
+		if (port<0)
+			continue; /* port is gone */
+
+		caps=plugin->plugin_caps->control_port_caps[port];
+
+		if ((unsigned int)caps->type!=entry.type || caps->common.plug_type==DSPLUG_PLUG_OUTPUT)
+			continue;
+
+		switch (caps->type) {
+
+			case DSPLUG_CONTROL_PORT_TYPE_NUMERICAL: {
+
+				if (!caps->set_callback_numerical)
+					continue;
+
+				/* a repeated entry overrides the previous one, so the batch never outgrows the ports */
+				if (!plugin->state_batch_slots[port]) {
+
+					plugin->state_batch_ports[n]=port;
+					plugin->state_batch_slots[port]=++n;
+				}
+
+				memcpy(&plugin->state_batch_values[plugin->state_batch_slots[port]-1],value,sizeof(float));
+			} break;
+			case DSPLUG_CONTROL_PORT_TYPE_STRING: {
+
+				DSPlug_PluginInstance_set_control_string_port(p_instance,port,value);
+			} break;
+			case DSPLUG_CONTROL_PORT_TYPE_DATA: {
+
+				/* asynchronous ports build their object here, and get it at the next cycle */
+				if (caps->prepare_callback_data)
+					DSPlug_PluginInstance_set_control_data_port_async(p_instance,port,value,entry.value_length);
+				else
+					DSPlug_PluginInstance_set_control_data_port(p_instance,port,value,entry.value_length);
+			} break;
+		}
+	}
+
+	for (i=0;i<(unsigned int)n;i++)
+		plugin->state_batch_slots[plugin->state_batch_ports[i]]=0;
+
+	if (n)
+		DSPlug_PluginInstance_set_control_numerical_ports(p_instance,plugin->state_batch_ports,plugin->state_batch_values,n);
+
+	return DSPLUG_TRUE;
+}
+
+DSPlug_Boolean DSPlug_PluginInstance_load_state_file( DSPlug_PluginInstance *p_instance, const char *p ) {
+
+	struct stat st;
+	void *map;
+	int fd;
+	DSPlug_Boolean loaded;
+
+	fd=open(p,O_RDONLY);
+
+	if (fd<0) {
+
+		DSPlug_report_error("HOST: DSPlug_PluginInstance_load_state_file: Can't open file");
+		return DSPLUG_FALSE;
+	}
+
+	if (fstat(fd,&st)<0 || st.st_size<(off_t)sizeof(DSPlug_StateHeader)) {
+
+		close(fd);
+		DSPlug_report_error("HOST: DSPlug_PluginInstance_load_state_file: Invalid state snapshot file");
+		return DSPLUG_FALSE;
+	}
+
+	map=mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd); /* the mapping keeps the file */
+
+	if (map==MAP_FAILED) {
+
+		DSPlug_report_error("HOST: DSPlug_PluginInstance_load_state_file: Can't map file");
+		return DSPLUG_FALSE;
+	}
+
+	loaded=DSPlug_PluginInstance_load_state(p_instance,map,(int)st.st_size);
+
+	munmap(map,st.st_size);
+
+	return loaded;
+}
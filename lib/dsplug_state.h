@@ -0,0 +1,61 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef DSPLUG_STATE_H
+#define DSPLUG_STATE_H
+
+#include "dsplug_types.h"
+
+/*
+	State snapshot format, see DSPlug_PluginInstance_save_state.
+*/
+
+#define DSPLUG_STATE_MAGIC "DSPLUGST"
+#define DSPLUG_STATE_VERSION 1
+#define DSPLUG_STATE_BYTE_ORDER 0x01020304 /* reads differently on the other endianness */
+#define DSPLUG_STATE_ALIGNMENT 4
+
+/**
+ * Snapshot header, followed by entry_count entries
+ */
+typedef struct {
+
+	char magic[8];
+	unsigned int version;
+	unsigned int byte_order;
+	unsigned int entry_count;
+	unsigned int size; /**< whole snapshot, header included */
+
+} DSPlug_StateHeader;
+
+/**
+ * Every entry is this header, the key (full path and name of the port, with
+ * the ending 0), the value, and padding up to DSPLUG_STATE_ALIGNMENT.
+ * Numerical values are a float, strings include the ending 0.
+ */
+typedef struct {
+
+	unsigned int size; /**< whole entry, padding included */
+	unsigned int type; /**< DSPlug_ControlPortType */
+	unsigned int key_length;
+	unsigned int value_length;
+
+} DSPlug_StateEntryHeader;
+
+DSPlug_Boolean DSPlug_state_check( const char *b, int l, DSPlug_StateHeader *header ); /* checks the header and every entry */
+DSPlug_Boolean DSPlug_state_read_entry( const char *b, int l, int *pos, DSPlug_StateEntryHeader *entry, const char **key, const char **value ); /* reads the entry at *pos and moves past it */
+
+#endif
@@ -0,0 +1,425 @@
+/***************************************************************************
+    This file is part of the DSPlug DSP Plugin Architecture
+    url                  : http://www.dsplug.org
+    copyright            : (C) 2005 by Juan Linietsky
+    email                : coding -dontspamme- *AT* -please- reduz *DOT* com *DOT* ar
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Lesser General Public License (LGPL)    *
+ *   as published by the Free Software Foundation; either version 2.1 of   *
+ *   the License, or (at your option) any later version.                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "dsplug_host.h"
+#include "dsplug_error_report.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DSPLUG_TEMPO_MAP_FRAME_GRANULARITY 256 /* frames per frame lookup entry */
+#define DSPLUG_TEMPO_MAP_BEAT_RESOLUTION 16 /* beat lookup entries per beat */
+#define DSPLUG_TEMPO_MAP_DEFAULT_LENGTH 600 /* default lookup length, in seconds */
+
+/**
+ * The tempo is constant inside a segment, so positions inside
+ * it are just a linear function of the frame.
+ */
+typedef struct {
+
+	double frame; /**< song frame where the segment begins */
+	double beat; /**< song beat where the segment begins */
+	double tempo; /**< beats per minute */
+	double beats_per_frame;
+
+} DSPlug_TempoSegment;
+
+typedef struct {
+
+	float sampling_rate;
+
+	DSPlug_TempoSegment *segments; /**< sorted by frame, the first one is always at frame zero */
+	int segment_count;
+
+	/* Lookup tables, contain the segment index at the beginning of each entry */
+
+	double lookup_length; /**< in frames */
+	int *frame_lookup;
+	int frame_lookup_size;
+	int *beat_lookup;
+	int beat_lookup_size;
+
+	/* Misc mastertrack info */
+
+	int time_signature_numerator;
+	int time_signature_denominator;
+	int key;
+	DSPlug_Boolean key_minor;
+
+} DSPlug_TempoMapPrivate;
+
+
+/* Binary search for the last segment beginning at or before a frame, among segments low to high */
+static int DSPlug_TempoMap_search_segment_by_frame_range( DSPlug_TempoMapPrivate *map, double f, int low, int high ) {
+
+	int mid;
+
+	while (low<high) {
+
+		mid=(low+high+1)/2;
+		if (map->segments[mid].frame<=f)
+			low=mid;
+		else
+			high=mid-1;
+	}
+
+	return low;
+}
+
+/* Binary search for the last segment beginning at or before a beat, among segments low to high */
+static int DSPlug_TempoMap_search_segment_by_beat_range( DSPlug_TempoMapPrivate *map, double b, int low, int high ) {
+
+	int mid;
+
+	while (low<high) {
+
+		mid=(low+high+1)/2;
+		if (map->segments[mid].beat<=b)
+			low=mid;
+		else
+			high=mid-1;
+	}
+
+	return low;
+}
+
+static int DSPlug_TempoMap_search_segment_by_frame( DSPlug_TempoMapPrivate *map, double f ) {
+
+	return DSPlug_TempoMap_search_segment_by_frame_range(map,f,0,map->segment_count-1);
+}
+
+static int DSPlug_TempoMap_search_segment_by_beat( DSPlug_TempoMapPrivate *map, double b ) {
+
+	return DSPlug_TempoMap_search_segment_by_beat_range(map,b,0,map->segment_count-1);
+}
+
+static int DSPlug_TempoMap_find_segment_by_frame( DSPlug_TempoMapPrivate *map, double f ) {
+
+	int entry,last;
+
+	if (f<0)
+		return 0;
+
+	if (f>=(double)map->frame_lookup_size*DSPLUG_TEMPO_MAP_FRAME_GRANULARITY)
+		return DSPlug_TempoMap_search_segment_by_frame(map,f);
+
+	entry=(int)(f/DSPLUG_TEMPO_MAP_FRAME_GRANULARITY);
+
+	/* tempo changes may happen inside the lookup entry, they are all before the segment of the next one */
+	last=(entry+1<map->frame_lookup_size) ? map->frame_lookup[entry+1] : map->segment_count-1;
+
+	return DSPlug_TempoMap_search_segment_by_frame_range(map,f,map->frame_lookup[entry],last);
+}
+
+static int DSPlug_TempoMap_find_segment_by_beat( DSPlug_TempoMapPrivate *map, double b ) {
+
+	int entry,last;
+
+	if (b<0)
+		return 0;
+
+	if (b>=(double)map->beat_lookup_size/DSPLUG_TEMPO_MAP_BEAT_RESOLUTION)
+		return DSPlug_TempoMap_search_segment_by_beat(map,b);
+
+	entry=(int)(b*DSPLUG_TEMPO_MAP_BEAT_RESOLUTION);
+	last=(entry+1<map->beat_lookup_size) ? map->beat_lookup[entry+1] : map->segment_count-1;
+
+	return DSPlug_TempoMap_search_segment_by_beat_range(map,b,map->beat_lookup[entry],last);
+}
+
+/* Recompute the beat position of the segments, from a given one */
+static void DSPlug_TempoMap_update_segments( DSPlug_TempoMapPrivate *map, int from ) {
+
+	int i;
+	DSPlug_TempoSegment *segment;
+
+	for (i=from;i<map->segment_count;i++) {
+
+		segment=&map->segments[i];
+		segment->beats_per_frame=segment->tempo/(60.0*map->sampling_rate);
+
+		if (i==0)
+			segment->beat=0;
+		else
+			segment->beat=segment[-1].beat+(segment->frame-segment[-1].frame)*segment[-1].beats_per_frame;
+	}
+}
+
+/* Rebuild the lookup tables, only from a given frame onwards */
+static void DSPlug_TempoMap_update_lookup( DSPlug_TempoMapPrivate *map, double from ) {
+
+	int i,segment,first;
+	int beat_lookup_size;
+	double length_beats;
+
+	/* Frame table */
+
+	first=(int)(from/DSPLUG_TEMPO_MAP_FRAME_GRANULARITY);
+	if (first<0)
+		first=0;
+
+	segment=DSPlug_TempoMap_search_segment_by_frame(map,(double)first*DSPLUG_TEMPO_MAP_FRAME_GRANULARITY);
+
+	for (i=first;i<map->frame_lookup_size;i++) {
+
+		while (segment+1<map->segment_count && map->segments[segment+1].frame<=(double)i*DSPLUG_TEMPO_MAP_FRAME_GRANULARITY)
+			segment++;
+
+		map->frame_lookup[i]=segment;
+	}
+
+	/* Beat table, its size depends on the tempo */
+
+	segment=DSPlug_TempoMap_search_segment_by_frame(map,map->lookup_length);
+	length_beats=map->segments[segment].beat+(map->lookup_length-map->segments[segment].frame)*map->segments[segment].beats_per_frame;
+	beat_lookup_size=(int)(length_beats*DSPLUG_TEMPO_MAP_BEAT_RESOLUTION)+1;
+
+	segment=DSPlug_TempoMap_search_segment_by_frame(map,from);
+	first=(int)((map->segments[segment].beat+(from-map->segments[segment].frame)*map->segments[segment].beats_per_frame)*DSPLUG_TEMPO_MAP_BEAT_RESOLUTION);
+	if (first<0)
+		first=0;
+
+	if (beat_lookup_size!=map->beat_lookup_size) {
+
+		map->beat_lookup=(int*)realloc(map->beat_lookup,sizeof(int)*beat_lookup_size);
+		if (first>map->beat_lookup_size)
+			first=map->beat_lookup_size; /* new entries must be filled too */
+		map->beat_lookup_size=beat_lookup_size;
+	}
+
+	segment=DSPlug_TempoMap_search_segment_by_beat(map,(double)first/DSPLUG_TEMPO_MAP_BEAT_RESOLUTION);
+
+	for (i=first;i<map->beat_lookup_size;i++) {
+
+		while (segment+1<map->segment_count && map->segments[segment+1].beat<=(double)i/DSPLUG_TEMPO_MAP_BEAT_RESOLUTION)
+			segment++;
+
+		map->beat_lookup[i]=segment;
+	}
+}
+
+
+DSPlug_TempoMap * DSPlug_TempoMap_create( float r, double t ) {
+
+	DSPlug_TempoMap *map_public;
+	DSPlug_TempoMapPrivate *map;
+
+	if (r<=0 || t<=0) {
+
+		DSPlug_report_error("HOST: DSPlug_TempoMap_create: Invalid sampling rate or tempo");
+		return NULL;
+	}
+
+	map = (DSPlug_TempoMapPrivate*)malloc(sizeof(DSPlug_TempoMapPrivate));
+	memset(map,0,sizeof(DSPlug_TempoMapPrivate));
+
+	map->sampling_rate=r;
+	map->time_signature_numerator=4;
+	map->time_signature_denominator=4;
+
+	map->segment_count=1;
+	map->segments=(DSPlug_TempoSegment*)malloc(sizeof(DSPlug_TempoSegment));
+	map->segments[0].frame=0;
+	map->segments[0].tempo=t;
+	DSPlug_TempoMap_update_segments(map,0);
+
+	map_public = (DSPlug_TempoMap*)malloc(sizeof(DSPlug_TempoMap));
+	map_public->_private=map;
+
+	DSPlug_TempoMap_set_lookup_length(map_public,(double)r*DSPLUG_TEMPO_MAP_DEFAULT_LENGTH);
+
+	return map_public;
+}
+
+void DSPlug_TempoMap_destroy( DSPlug_TempoMap *p_map ) {
+
+	DSPlug_TempoMapPrivate *map;
+
+	if (!p_map || !p_map->_private) {
+
+		DSPlug_report_error("HOST: DSPlug_TempoMap_destroy: Invalid TempoMap object (NULL)");
+		return;
+	}
+
+	map = (DSPlug_TempoMapPrivate*)p_map->_private;
+
+	free(map->segments);
+	free(map->frame_lookup);
+	free(map->beat_lookup);
+	free(map);
+	free(p_map);
+}
+
+void DSPlug_TempoMap_set_tempo( DSPlug_TempoMap *p_map, double f, double t ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+	int segment;
+
+	if (f<0 || t<=0) {
+
+		DSPlug_report_error("HOST: DSPlug_TempoMap_set_tempo: Invalid frame or tempo");
+		return;
+	}
+
+	segment=DSPlug_TempoMap_search_segment_by_frame(map,f);
+
+	if (map->segments[segment].frame!=f) {
+
+		/* insert a new segment after the one containing the frame */
+		segment++;
+		map->segment_count++;
+		map->segments=(DSPlug_TempoSegment*)realloc(map->segments,sizeof(DSPlug_TempoSegment)*map->segment_count);
+		memmove(&map->segments[segment+1],&map->segments[segment],sizeof(DSPlug_TempoSegment)*(map->segment_count-segment-1));
+		map->segments[segment].frame=f;
+	}
+
+	map->segments[segment].tempo=t;
+
+	DSPlug_TempoMap_update_segments(map,segment);
+	DSPlug_TempoMap_update_lookup(map,f);
+}
+
+void DSPlug_TempoMap_clear( DSPlug_TempoMap *p_map, double t ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+
+	if (t<=0) {
+
+		DSPlug_report_error("HOST: DSPlug_TempoMap_clear: Invalid tempo");
+		return;
+	}
+
+	map->segment_count=1;
+	map->segments[0].tempo=t;
+
+	DSPlug_TempoMap_update_segments(map,0);
+	DSPlug_TempoMap_update_lookup(map,0);
+}
+
+void DSPlug_TempoMap_set_time_signature( DSPlug_TempoMap *p_map, int n, int d ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+
+	if (n<=0 || d<=0) {
+
+		DSPlug_report_error("HOST: DSPlug_TempoMap_set_time_signature: Invalid time signature");
+		return;
+	}
+
+	map->time_signature_numerator=n;
+	map->time_signature_denominator=d;
+}
+
+void DSPlug_TempoMap_set_key( DSPlug_TempoMap *p_map, int k, DSPlug_Boolean m ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+
+	if (k<0 || k>11) {
+
+		DSPlug_report_error("HOST: DSPlug_TempoMap_set_key: Invalid key");
+		return;
+	}
+
+	map->key=k;
+	map->key_minor=m;
+}
+
+void DSPlug_TempoMap_set_lookup_length( DSPlug_TempoMap *p_map, double f ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+
+	if (f<0) {
+
+		DSPlug_report_error("HOST: DSPlug_TempoMap_set_lookup_length: Invalid length");
+		return;
+	}
+
+	map->lookup_length=f;
+	map->frame_lookup_size=(int)(f/DSPLUG_TEMPO_MAP_FRAME_GRANULARITY)+1;
+	map->frame_lookup=(int*)realloc(map->frame_lookup,sizeof(int)*map->frame_lookup_size);
+
+	DSPlug_TempoMap_update_lookup(map,0);
+}
+
+double DSPlug_TempoMap_get_tempo( DSPlug_TempoMap *p_map, double f ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+
+	return map->segments[DSPlug_TempoMap_find_segment_by_frame(map,f)].tempo;
+}
+
+double DSPlug_TempoMap_frame_to_beat( DSPlug_TempoMap *p_map, double f ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+	DSPlug_TempoSegment *segment = &map->segments[DSPlug_TempoMap_find_segment_by_frame(map,f)];
+
+	return segment->beat+(f-segment->frame)*segment->beats_per_frame;
+}
+
+double DSPlug_TempoMap_beat_to_frame( DSPlug_TempoMap *p_map, double b ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+	DSPlug_TempoSegment *segment = &map->segments[DSPlug_TempoMap_find_segment_by_beat(map,b)];
+
+	return segment->frame+(b-segment->beat)/segment->beats_per_frame;
+}
+
+int DSPlug_TempoMap_push_cycle_events( DSPlug_TempoMap *p_map, DSPlug_EventQueue *q, double f, int l ) {
+
+	DSPlug_TempoMapPrivate *map = (DSPlug_TempoMapPrivate*)p_map->_private;
+	DSPlug_Event ev;
+	int segment=DSPlug_TempoMap_find_segment_by_frame(map,f);
+	int pushed=0;
+
+	memset(&ev,0,sizeof(DSPlug_Event));
+
+	/* Full state at the beginning of the cycle */
+
+	ev.type=DSPLUG_MASTERTRACK_EVENT_TEMPO;
+	ev.data.real=map->segments[segment].tempo;
+	pushed+=DSPlug_EventQueue_push(q,&ev);
+
+	ev.type=DSPLUG_MASTERTRACK_EVENT_BEAT_POSITION;
+	ev.data.real=map->segments[segment].beat+(f-map->segments[segment].frame)*map->segments[segment].beats_per_frame;
+	pushed+=DSPlug_EventQueue_push(q,&ev);
+
+	ev.type=DSPLUG_MASTERTRACK_EVENT_TIME_SIGNATURE;
+	ev.data.integers[0]=map->time_signature_numerator;
+	ev.data.integers[1]=map->time_signature_denominator;
+	pushed+=DSPlug_EventQueue_push(q,&ev);
+
+	ev.type=DSPLUG_MASTERTRACK_EVENT_KEY;
+	ev.data.integers[0]=map->key;
+	ev.data.integers[1]=map->key_minor;
+	pushed+=DSPlug_EventQueue_push(q,&ev);
+
+	/* Tempo changes inside the cycle */
+
+	for (segment++;segment<map->segment_count && map->segments[segment].frame<f+l;segment++) {
+
+		ev.frame=(int)(map->segments[segment].frame-f);
+
+		ev.type=DSPLUG_MASTERTRACK_EVENT_TEMPO;
+		ev.data.real=map->segments[segment].tempo;
+		pushed+=DSPlug_EventQueue_push(q,&ev);
+
+		ev.type=DSPLUG_MASTERTRACK_EVENT_BEAT_POSITION;
+		ev.data.real=map->segments[segment].beat;
+		pushed+=DSPlug_EventQueue_push(q,&ev);
+	}
+
+	return pushed;
+}